@@ -0,0 +1,453 @@
+// Benchmarks for the hot paths of the game. Run with `make bench`; results
+// are printed and written as JSON (default bench_results.json) so two
+// builds can be diffed.
+
+#include "../src/Simulation.h"
+#include "../src/Renderer.h"
+#include "../src/EndGame.h"
+#include "../src/Bot.h"
+#include "../src/Profiler.h"
+#include "../src/Rng.h"
+#include "../src/Utils.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Count every heap allocation made by the benchmarked code
+static std::atomic<long> allocations(0);
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct Result {
+    std::string name;
+    std::string board;
+    long iterations;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+std::vector<Result> results;
+
+const double MIN_SECONDS = 0.2;
+
+// Runs op in growing batches until MIN_SECONDS have passed
+void measure(const std::string& name, const std::string& board, const std::function<void()>& op) {
+    typedef std::chrono::steady_clock Clock;
+
+    op();   // warm-up
+    long iterations = 0;
+    long batch = 1;
+    long allocs = 0;
+    double seconds = 0;
+    while (seconds < MIN_SECONDS) {
+        long before = allocations.load();
+        Clock::time_point start = Clock::now();
+        for (long i = 0; i < batch; i++) {
+            op();
+        }
+        seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        allocs += allocations.load() - before;
+        iterations += batch;
+        batch *= 2;
+    }
+
+    Result r;
+    r.name = name;
+    r.board = board;
+    r.iterations = iterations;
+    r.nsPerOp = seconds * 1e9 / iterations;
+    r.allocsPerOp = static_cast<double>(allocs) / iterations;
+    results.push_back(r);
+    std::printf("%-28s %-11s %12.1f ns/op %8.2f allocs/op %10ld ops\n",
+                name.c_str(), board.c_str(), r.nsPerOp, r.allocsPerOp, iterations);
+    std::fflush(stdout);
+}
+
+// Like measure(), but only op is timed: advance() runs untimed before each
+// call, for ops that need the state moved on between calls. Each call also
+// pays for a pair of clock reads.
+void measureAlone(const std::string& name, const std::string& board,
+                  const std::function<void()>& advance, const std::function<void()>& op) {
+    typedef std::chrono::steady_clock Clock;
+
+    advance();
+    op();   // warm-up
+    long iterations = 0;
+    long allocs = 0;
+    double timed = 0;
+    Clock::time_point begin = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - begin).count() < MIN_SECONDS) {
+        for (int i = 0; i < 1024; i++) {
+            advance();
+            long before = allocations.load();
+            Clock::time_point start = Clock::now();
+            op();
+            timed += std::chrono::duration<double>(Clock::now() - start).count();
+            allocs += allocations.load() - before;
+        }
+        iterations += 1024;
+    }
+
+    Result r;
+    r.name = name;
+    r.board = board;
+    r.iterations = iterations;
+    r.nsPerOp = timed * 1e9 / iterations;
+    r.allocsPerOp = static_cast<double>(allocs) / iterations;
+    results.push_back(r);
+    std::printf("%-28s %-11s %12.1f ns/op %8.2f allocs/op %10ld ops\n",
+                name.c_str(), board.c_str(), r.nsPerOp, r.allocsPerOp, iterations);
+    std::fflush(stdout);
+}
+
+// Upper half randomly filled with all brick types, same for every run
+EndGame generateBoard(int width, int height) {
+    EndGame endgame;
+    endgame.filename = "bench_" + std::to_string(width) + "x" + std::to_string(height);
+    endgame.width = width;
+    endgame.height = height;
+    endgame.initialLevel = 1;
+    endgame.bricks.resize(width, height);
+
+    Rng rng(width * 7919ULL + height);
+    static const BrickType types[3] = {
+        BrickType::NORMAL, BrickType::DURABLE, BrickType::INDESTRUCTIBLE
+    };
+    for (int y = 0; y < height / 2; y++) {
+        for (int x = 0; x < width; x++) {
+            if (rng.below(2)) {
+                endgame.bricks.set(x, y, types[rng.below(10) < 8 ? rng.below(2) : 2]);
+            }
+        }
+    }
+    return endgame;
+}
+
+// Huge board with a few dense blocks and nothing elsewhere, so only the
+// blocks' chunks are stored
+EndGame generateSparseBoard(int width, int height) {
+    EndGame endgame;
+    endgame.filename = "bench_sparse_" + std::to_string(width) + "x" + std::to_string(height);
+    endgame.width = width;
+    endgame.height = height;
+    endgame.initialLevel = 1;
+    endgame.bricks.resize(width, height);
+
+    Rng rng(width * 7919ULL + height);
+    for (int block = 0; block < 16; block++) {
+        int x0 = rng.below(width - 128);
+        int y0 = rng.below(height / 2);
+        for (int y = y0; y < y0 + 32; y++) {
+            for (int x = x0; x < x0 + 128; x++) {
+                endgame.bricks.set(x, y, rng.below(4) ? BrickType::NORMAL : BrickType::DURABLE);
+            }
+        }
+    }
+    return endgame;
+}
+
+void startGame(Simulation& sim, const EndGame& endgame, uint64_t seed) {
+    sim.seed(seed);
+    sim.reset(1);
+    sim.loadEndGame(endgame);
+}
+
+void benchBoard(const EndGame& endgame, int nullFd) {
+    const int width = endgame.width;
+    const int height = endgame.height;
+    std::string board = std::to_string(width) + "x" + std::to_string(height);
+
+    Simulation sim(width, height);
+    sim.setBallStep(5.0 / 60.0);
+    Bot bot(1);
+    uint64_t seed = 1;
+    startGame(sim, endgame, seed);
+
+    // Ball movement and collisions, played by the bot so it stays in play
+    measure("simulation.step", board, [&]() {
+        StepEvent event = sim.step(bot.decide(sim));
+        if (event != StepEvent::NONE) {
+            startGame(sim, endgame, ++seed);
+        }
+    });
+
+    // The autopilot's decision on its own, the game moving on a tick
+    // between decisions as it does in play
+    Simulation piloted(width, height);
+    piloted.setBallStep(5.0 / 60.0);
+    Bot pilot(1);
+    uint64_t pilotSeed = 1;
+    startGame(piloted, endgame, pilotSeed);
+    Input decision;
+    measureAlone("bot.decide", board, [&]() {
+        if (piloted.step(decision) != StepEvent::NONE) {
+            startGame(piloted, endgame, ++pilotSeed);
+        }
+    }, [&]() {
+        decision = pilot.decide(piloted);
+    });
+
+    // A tick with the ball on the paddle: input, the level-complete check
+    // and dirty tracking only
+    Simulation idle(width, height);
+    startGame(idle, endgame, 1);
+    Input nudge;
+    int direction = 1;
+    measure("simulation.step.idle", board, [&]() {
+        nudge.move = direction;
+        idle.step(nudge);
+        direction = -direction;
+    });
+
+    // Every destroyed brick splits the ball, so this runs close to the cap
+    Simulation multi(width, height);
+    multi.setBallStep(5.0 / 60.0);
+    multi.setPowerUps(1.0, Simulation::MAX_BALLS);
+    Bot multiBot(1);
+    uint64_t multiSeed = 1;
+    startGame(multi, endgame, multiSeed);
+    measure("simulation.multiball", board, [&]() {
+        StepEvent event = multi.step(multiBot.decide(multi));
+        if (event != StepEvent::NONE) {
+            startGame(multi, endgame, ++multiSeed);
+        }
+    });
+
+    // Both again with 16.16 integer physics
+    Simulation fixed(width, height);
+    fixed.setFixedPoint(true);
+    fixed.setBallStep(5.0 / 60.0);
+    Bot fixedBot(1);
+    uint64_t fixedSeed = 1;
+    startGame(fixed, endgame, fixedSeed);
+    measure("simulation.step.fixed", board, [&]() {
+        StepEvent event = fixed.step(fixedBot.decide(fixed));
+        if (event != StepEvent::NONE) {
+            startGame(fixed, endgame, ++fixedSeed);
+        }
+    });
+
+    Simulation fixedMulti(width, height);
+    fixedMulti.setFixedPoint(true);
+    fixedMulti.setBallStep(5.0 / 60.0);
+    fixedMulti.setPowerUps(1.0, Simulation::MAX_BALLS);
+    Bot fixedMultiBot(1);
+    uint64_t fixedMultiSeed = 1;
+    startGame(fixedMulti, endgame, fixedMultiSeed);
+    measure("simulation.multiball.fixed", board, [&]() {
+        StepEvent event = fixedMulti.step(fixedMultiBot.decide(fixedMulti));
+        if (event != StepEvent::NONE) {
+            startGame(fixedMulti, endgame, ++fixedMultiSeed);
+        }
+    });
+
+    measure("simulation.loadEndGame", board, [&]() {
+        idle.loadEndGame(endgame);
+    });
+
+    // Frame composition, written to /dev/null
+    Renderer renderer(nullFd);
+    measure("renderer.full", board, [&]() {
+        renderer.invalidate();
+        renderer.render(sim, false);
+    });
+
+    startGame(sim, endgame, seed);
+    renderer.render(sim, false);
+    measure("renderer.incremental", board, [&]() {
+        StepEvent event = sim.step(bot.decide(sim));
+        if (event != StepEvent::NONE) {
+            startGame(sim, endgame, ++seed);
+        }
+        renderer.track(sim);
+        renderer.render(sim, false);
+    });
+
+    // File formats, in the temporary working directory
+    endgame.saveToFile();
+    measure("endgame.saveText", board, [&]() {
+        endgame.saveToFile();
+    });
+    EndGame loaded;
+    measure("endgame.loadText", board, [&]() {
+        loaded.loadFromFile(endgame.filename);
+    });
+
+    std::string binary = "endgames/" + endgame.filename + ".endb";
+    measure("endgame.saveBinary", board, [&]() {
+        endgame.saveBinary(binary);
+    });
+    measure("endgame.loadBinary", board, [&]() {
+        loaded.loadFromFile(endgame.filename);
+    });
+    unlink(binary.c_str());
+}
+
+// The free-flight kernel on its own, once per instruction set the CPU has
+void benchBallKernels() {
+    const int count = 4096;
+    const int width = 1024;
+    BallStore balls;
+    Rng rng(count);
+    for (int i = 0; i < count; i++) {
+        Ball ball;
+        ball.attached = false;
+        ball.x = rng.unit() * width;
+        ball.y = rng.unit() * width;
+        ball.dx = rng.unit() * 3 - 1.5;
+        ball.dy = (rng.below(2) ? 1 : -1) * (0.5 + rng.unit() * 0.5);
+        balls.push(ball);
+        balls.flags[i] |= BallStore::FREE;
+    }
+
+    const BallKernel kernels[3] = { BallKernel::SCALAR, BallKernel::SSE2, BallKernel::AVX2 };
+    const char* names[3] = { "balls.integrate.scalar", "balls.integrate.sse2", "balls.integrate.avx2" };
+    bool avx2 = (BallStore::bestKernel() == BallKernel::AVX2);
+    for (int k = 0; k < 3 && (kernels[k] != BallKernel::AVX2 || avx2); k++) {
+        BallStore copy = balls;
+        // Far bottom, so no ball is ever lost
+        measure(names[k], std::to_string(count) + " balls", [&]() {
+            copy.integrateFree(5.0 / 60.0, width, 1 << 30, kernels[k]);
+        });
+    }
+}
+
+// Cost of a timed scope in the game loop, with profiling off and on
+void benchProfiler() {
+    Profiler profiler;
+    volatile int sink = 0;
+    measure("profiler.scope.off", "-", [&]() {
+        ScopedTimer timer(profiler, Phase::SIMULATE);
+        sink = sink + 1;
+    });
+    profiler.enable(true);
+    measure("profiler.scope.on", "-", [&]() {
+        ScopedTimer timer(profiler, Phase::SIMULATE);
+        sink = sink + 1;
+    });
+}
+
+// Plays sessions with the bot, restarting every so often, and counts the
+// allocations made after the first one. Play, restarts, level transitions
+// and new sessions on the same board must all reuse their storage.
+bool checkAllocationFree(int nullFd) {
+    Simulation sim(9, 18);
+    sim.setBallStep(0.5);
+    sim.setPowerUps(0.25, Simulation::MAX_BALLS);
+    Renderer renderer(nullFd);
+    Bot bot(1);
+    long steps = 0;
+    int restarts = 0;
+    int transitions = 0;
+
+    long before = 0;
+    for (uint64_t seed = 1; seed <= 4; seed++) {
+        if (seed == 2) before = allocations.load();
+        sim.seed(seed);
+        sim.reset(1);
+        renderer.invalidate();
+        for (long t = 1; t <= 100000; t++) {
+            Input input = bot.decide(sim);
+            if (t % 20000 == 0) {
+                input.restart = true;
+                restarts++;
+            }
+            StepEvent event = sim.step(input);
+            renderer.track(sim);
+            renderer.render(sim, false);
+            steps++;
+            if (event == StepEvent::LEVEL_COMPLETE) transitions++;
+            if (event == StepEvent::GAME_WON || event == StepEvent::GAME_OVER) break;
+        }
+    }
+    long allocs = allocations.load() - before;
+
+    std::printf("%-28s %ld steps, %d restarts, %d level transitions: %ld allocations\n",
+                "allocation.check", steps, restarts, transitions, allocs);
+    return allocs == 0 && transitions > 0 && restarts > 0;
+}
+
+bool writeJson(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << "  { \"name\": \"" << r.name << "\", \"board\": \"" << r.board
+             << "\", \"iterations\": " << r.iterations
+             << ", \"ns_per_op\": " << r.nsPerOp
+             << ", \"allocs_per_op\": " << r.allocsPerOp << " }"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "]\n";
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = (argc > 1) ? argv[1] : "bench_results.json";
+    if (output[0] != '/') {
+        char cwd[4096];
+        if (getcwd(cwd, sizeof(cwd))) output = std::string(cwd) + "/" + output;
+    }
+
+    // Endgame files go to a scratch directory
+    char scratch[] = "/tmp/breakout_bench_XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0) {
+        std::cerr << "Failed to create scratch directory" << std::endl;
+        return 1;
+    }
+    Utils::createDirectory("endgames");
+
+    int nullFd = open("/dev/null", O_WRONLY);
+
+    const int sizes[][2] = { { 9, 18 }, { 64, 64 }, { 256, 256 }, { 1024, 1024 } };
+    for (const auto& size : sizes) {
+        benchBoard(generateBoard(size[0], size[1]), nullFd);
+    }
+    benchBoard(generateSparseBoard(10000, 10000), nullFd);
+    benchBallKernels();
+    benchProfiler();
+    bool allocationFree = checkAllocationFree(nullFd);
+
+    close(nullFd);
+    std::system((std::string("rm -rf ") + scratch).c_str());
+
+    if (!writeJson(output)) {
+        std::cerr << "Failed to write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << output << std::endl;
+    if (!allocationFree) {
+        std::cerr << "Steady-state play allocated memory" << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "BallStore.h"
+#include "Fixed.h"
+#include <cstring>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define BALLSTORE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Raw field pointers. Going through the vectors inside the loops would make
+// the compiler reload them after every flag store, since uint8_t may alias.
+struct Fields {
+    double* x;
+    double* y;
+    double* dx;
+    double* dy;
+    uint8_t* flags;
+    size_t count;
+    
+    explicit Fields(BallStore& balls)
+        : x(balls.x.data()), y(balls.y.data()), dx(balls.dx.data()), dy(balls.dy.data()),
+          flags(balls.flags.data()), count(balls.size()) {}
+};
+
+// Scalar reference; the vector kernels do exactly the same operations in the
+// same order, so they round the same way
+inline void moveOne(const Fields& balls, size_t i, double step, double width, double twoWidth,
+                    double height) {
+    double dx = balls.dx[i];
+    double dy = balls.dy[i];
+    double x = balls.x[i] + dx * step;
+    double y = balls.y[i] + dy * step;
+    
+    if (x <= 0) {
+        x = -x;
+        dx = -dx;
+    } else if (x >= width) {
+        x = twoWidth - x;
+        dx = -dx;
+    }
+    if (y <= 0 && dy < 0) {
+        y = -y;
+        dy = -dy;
+    }
+    if (y >= height && dy > 0) {
+        balls.flags[i] |= BallStore::LOST;
+    }
+    
+    balls.x[i] = x;
+    balls.y[i] = y;
+    balls.dx[i] = dx;
+    balls.dy[i] = dy;
+}
+
+void integrateScalar(const Fields& balls, size_t first, double step, double width, double height) {
+    for (size_t i = first; i < balls.count; i++) {
+        if (balls.flags[i] & BallStore::FREE) {
+            moveOne(balls, i, step, width, 2 * width, height);
+        }
+    }
+}
+
+#ifdef BALLSTORE_X86
+
+// Selects b where mask is set, a elsewhere
+inline __m128d select(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, b), _mm_andnot_pd(mask, a));
+}
+
+void integrateSse2(const Fields& balls, double step, double width, double height) {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    const __m128d vStep = _mm_set1_pd(step);
+    const __m128d vWidth = _mm_set1_pd(width);
+    const __m128d vTwoWidth = _mm_set1_pd(2 * width);
+    const __m128d vHeight = _mm_set1_pd(height);
+    const __m128i freeBit = _mm_set1_epi8(BallStore::FREE);
+    
+    size_t n = balls.count;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint16_t pair;
+        std::memcpy(&pair, balls.flags + i, 2);
+        if (!(pair & (BallStore::FREE * 0x0101))) continue;
+        // Spread each flag byte over its 64-bit lane, then test the bit
+        __m128i flags = _mm_cvtsi32_si128(pair);
+        flags = _mm_unpacklo_epi8(flags, flags);
+        flags = _mm_unpacklo_epi16(flags, flags);
+        flags = _mm_unpacklo_epi32(flags, flags);
+        __m128d free = _mm_castsi128_pd(_mm_cmpeq_epi8(_mm_and_si128(flags, freeBit), freeBit));
+        
+        __m128d x0 = _mm_loadu_pd(balls.x + i);
+        __m128d y0 = _mm_loadu_pd(balls.y + i);
+        __m128d dx0 = _mm_loadu_pd(balls.dx + i);
+        __m128d dy0 = _mm_loadu_pd(balls.dy + i);
+        __m128d x = _mm_add_pd(x0, _mm_mul_pd(dx0, vStep));
+        __m128d y = _mm_add_pd(y0, _mm_mul_pd(dy0, vStep));
+        
+        // Sign flips are done by xor-ing in the sign bit under a mask,
+        // which leaves lanes that aren't free untouched
+        __m128d left = _mm_and_pd(_mm_cmple_pd(x, zero), free);
+        __m128d right = _mm_andnot_pd(left, _mm_and_pd(_mm_cmpge_pd(x, vWidth), free));
+        x = _mm_xor_pd(x, _mm_and_pd(left, signBit));
+        x = select(right, x, _mm_sub_pd(vTwoWidth, x));
+        __m128d dx = _mm_xor_pd(dx0, _mm_and_pd(_mm_or_pd(left, right), signBit));
+        
+        __m128d top = _mm_and_pd(_mm_and_pd(_mm_cmple_pd(y, zero), _mm_cmplt_pd(dy0, zero)), free);
+        y = _mm_xor_pd(y, _mm_and_pd(top, signBit));
+        __m128d dy = _mm_xor_pd(dy0, _mm_and_pd(top, signBit));
+        __m128d lost = _mm_and_pd(_mm_cmpge_pd(y, vHeight), _mm_cmpgt_pd(dy, zero));
+        
+        _mm_storeu_pd(balls.x + i, select(free, x0, x));
+        _mm_storeu_pd(balls.y + i, select(free, y0, y));
+        _mm_storeu_pd(balls.dx + i, dx);
+        _mm_storeu_pd(balls.dy + i, dy);
+        
+        int lostMask = _mm_movemask_pd(_mm_and_pd(lost, free));
+        if (lostMask & 1) balls.flags[i] |= BallStore::LOST;
+        if (lostMask & 2) balls.flags[i + 1] |= BallStore::LOST;
+    }
+    integrateScalar(balls, i, step, width, height);
+}
+
+__attribute__((target("avx2")))
+void integrateAvx2(const Fields& balls, double step, double width, double height) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    const __m256d vStep = _mm256_set1_pd(step);
+    const __m256d vWidth = _mm256_set1_pd(width);
+    const __m256d vTwoWidth = _mm256_set1_pd(2 * width);
+    const __m256d vHeight = _mm256_set1_pd(height);
+    const __m256i freeBit = _mm256_set1_epi64x(BallStore::FREE);
+    
+    size_t n = balls.count;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32_t packed;
+        std::memcpy(&packed, balls.flags + i, 4);
+        __m256i flags = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        __m256d free = _mm256_castsi256_pd(
+            _mm256_cmpeq_epi64(_mm256_and_si256(flags, freeBit), freeBit));
+        if (_mm256_movemask_pd(free) == 0) continue;
+        
+        __m256d x0 = _mm256_loadu_pd(balls.x + i);
+        __m256d y0 = _mm256_loadu_pd(balls.y + i);
+        __m256d dx0 = _mm256_loadu_pd(balls.dx + i);
+        __m256d dy0 = _mm256_loadu_pd(balls.dy + i);
+        __m256d x = _mm256_add_pd(x0, _mm256_mul_pd(dx0, vStep));
+        __m256d y = _mm256_add_pd(y0, _mm256_mul_pd(dy0, vStep));
+        
+        __m256d left = _mm256_cmp_pd(x, zero, _CMP_LE_OQ);
+        __m256d right = _mm256_andnot_pd(left, _mm256_cmp_pd(x, vWidth, _CMP_GE_OQ));
+        x = _mm256_blendv_pd(x, _mm256_xor_pd(x, signBit), left);
+        x = _mm256_blendv_pd(x, _mm256_sub_pd(vTwoWidth, x), right);
+        __m256d dx = _mm256_blendv_pd(dx0, _mm256_xor_pd(dx0, signBit), _mm256_or_pd(left, right));
+        
+        __m256d top = _mm256_and_pd(_mm256_cmp_pd(y, zero, _CMP_LE_OQ),
+                                    _mm256_cmp_pd(dy0, zero, _CMP_LT_OQ));
+        y = _mm256_blendv_pd(y, _mm256_xor_pd(y, signBit), top);
+        __m256d dy = _mm256_blendv_pd(dy0, _mm256_xor_pd(dy0, signBit), top);
+        __m256d lost = _mm256_and_pd(_mm256_cmp_pd(y, vHeight, _CMP_GE_OQ),
+                                     _mm256_cmp_pd(dy, zero, _CMP_GT_OQ));
+        
+        _mm256_storeu_pd(balls.x + i, _mm256_blendv_pd(x0, x, free));
+        _mm256_storeu_pd(balls.y + i, _mm256_blendv_pd(y0, y, free));
+        _mm256_storeu_pd(balls.dx + i, _mm256_blendv_pd(dx0, dx, free));
+        _mm256_storeu_pd(balls.dy + i, _mm256_blendv_pd(dy0, dy, free));
+        
+        int lostMask = _mm256_movemask_pd(_mm256_and_pd(lost, free));
+        for (int k = 0; lostMask; k++, lostMask >>= 1) {
+            if (lostMask & 1) balls.flags[i + k] |= BallStore::LOST;
+        }
+    }
+    // The tail stays in this function and the upper halves are cleared
+    // before returning; mixing in SSE-encoded code with them dirty stalls
+    for (; i < n; i++) {
+        if (balls.flags[i] & BallStore::FREE) {
+            moveOne(balls, i, step, width, 2 * width, height);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+#endif
+
+}
+
+void BallStore::clear() {
+    x.clear();
+    y.clear();
+    dx.clear();
+    dy.clear();
+    flags.clear();
+}
+
+void BallStore::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    dx.resize(count);
+    dy.resize(count);
+    flags.resize(count);
+}
+
+void BallStore::reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    dx.reserve(count);
+    dy.reserve(count);
+    flags.reserve(count);
+}
+
+void BallStore::push(const Ball& ball) {
+    x.push_back(ball.x);
+    y.push_back(ball.y);
+    dx.push_back(ball.dx);
+    dy.push_back(ball.dy);
+    flags.push_back(ball.attached ? ATTACHED : 0);
+}
+
+Ball BallStore::get(size_t i) const {
+    Ball ball;
+    ball.x = x[i];
+    ball.y = y[i];
+    ball.dx = dx[i];
+    ball.dy = dy[i];
+    ball.attached = (flags[i] & ATTACHED) != 0;
+    return ball;
+}
+
+void BallStore::set(size_t i, const Ball& ball) {
+    x[i] = ball.x;
+    y[i] = ball.y;
+    dx[i] = ball.dx;
+    dy[i] = ball.dy;
+    flags[i] = ball.attached ? ATTACHED : 0;
+}
+
+void BallStore::integrateFree(double step, int width, int height, BallKernel kernel) {
+#ifdef BALLSTORE_X86
+    if (kernel == BallKernel::AVX2) {
+        integrateAvx2(Fields(*this), step, width, height);
+        return;
+    }
+    if (kernel == BallKernel::SSE2) {
+        integrateSse2(Fields(*this), step, width, height);
+        return;
+    }
+#endif
+    (void)kernel;
+    integrateScalar(Fields(*this), 0, step, width, height);
+}
+
+void BallStore::integrateFixed(int64_t step, int height) {
+    Fields balls(*this);
+    const int64_t bottom = height * Fixed::ONE;
+    for (size_t i = 0; i < balls.count; i++) {
+        if (!(balls.flags[i] & FREE)) continue;
+        int64_t vy = Fixed::mul(Fixed::fromDouble(balls.dy[i]), step);
+        int64_t y = Fixed::fromDouble(balls.y[i]) + vy;
+        balls.x[i] = Fixed::toDouble(Fixed::fromDouble(balls.x[i]) +
+                                     Fixed::mul(Fixed::fromDouble(balls.dx[i]), step));
+        balls.y[i] = Fixed::toDouble(y);
+        if (y >= bottom && vy > 0) balls.flags[i] |= LOST;
+    }
+}
+
+BallKernel BallStore::bestKernel() {
+#ifdef BALLSTORE_X86
+    if (__builtin_cpu_supports("avx2")) return BallKernel::AVX2;
+#endif
+    return BallKernel::SCALAR;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef BALLSTORE_H
+#define BALLSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Ball {
+    double x, y;
+    double dx, dy;
+    bool attached;      // only ever true for the first ball
+    
+    Ball() : x(0), y(0), dx(0), dy(0), attached(true) {}
+};
+
+// Instruction sets the free-flight kernel can run on
+enum class BallKernel {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Balls stored as one array per field, so a tick's worth of position
+// updates can be done several balls at a time
+struct BallStore {
+    enum : uint8_t {
+        ATTACHED = 1,   // sits on the paddle
+        FREE = 2,       // nothing but walls and the bottom within reach this tick
+        LOST = 4        // dropped out of the bottom
+    };
+    
+    std::vector<double> x, y;
+    std::vector<double> dx, dy;
+    std::vector<uint8_t> flags;
+    
+    size_t size() const { return flags.size(); }
+    bool empty() const { return flags.empty(); }
+    void clear();
+    void resize(size_t count);
+    void reserve(size_t count);
+    void push(const Ball& ball);
+    Ball get(size_t i) const;
+    void set(size_t i, const Ball& ball);
+    
+    // Moves every ball flagged FREE one tick: integrates its position,
+    // reflects it off the side walls (x = 0 and x = width) and the top, and
+    // flags it LOST once it reaches y = height. Every kernel gives
+    // bit-identical results.
+    void integrateFree(double step, int width, int height, BallKernel kernel);
+    // Fixed-point mode: moves every ball flagged FREE by one tick of its
+    // 16.16 velocity, in integers only, and flags it LOST once it reaches
+    // y = height. Doesn't bounce; FREE balls must be clear of the walls.
+    void integrateFixed(int64_t step, int height);
+    
+    // Kernel used by default: AVX2 where the CPU has it, scalar otherwise.
+    // SSE2 only covers two balls per instruction, which measures no faster
+    // than the scalar loop (see make bench), so it is never picked here.
+    static BallKernel bestKernel();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef BOARDSHAPE_H
+#define BOARDSHAPE_H
+
+#include "BrickGrid.h"
+#include <cstdint>
+
+// Board size and brick lookups for the per-tick collision code, which
+// Simulation builds once per shape. A shape is made fresh for every step,
+// so it never outlives a board change.
+//
+// Boards that fit in one chunk are read straight from its row masks: a
+// lookup is a load and a shift, with no chunk table in between. The
+// default board and the common endgame sizes also have their size known
+// at compile time, so their wall, paddle-line and clipping checks fold to
+// constants; see visitShape().
+
+// True if any of rows y0..y1 has a brick in columns x0..x1; the rectangle
+// is already clipped to the chunk
+inline bool anyInRows(const uint64_t* rows, int x0, int y0, int x1, int y1) {
+    if (x0 > x1 || y0 > y1) return false;
+    uint64_t columns = (~0ULL << x0) & (~0ULL >> (BrickGrid::CHUNK_MASK - x1));
+    for (int y = y0; y <= y1; y++) {
+        if (rows[y] & columns) return true;
+    }
+    return false;
+}
+
+template <int W, int H>
+class FixedShape {
+    static_assert(W <= BrickGrid::CHUNK_SIZE && H <= BrickGrid::CHUNK_SIZE,
+                  "fixed shapes are read from a single chunk");
+
+private:
+    const uint64_t* rows;
+
+public:
+    explicit FixedShape(const BrickGrid& grid) : rows(grid.rowMasks(0, 0)) {}
+    
+    int width() const { return W; }
+    int height() const { return H; }
+    bool brickAt(int x, int y) const {
+        return static_cast<unsigned>(x) < W && static_cast<unsigned>(y) < H && ((rows[y] >> x) & 1);
+    }
+    bool anyInRect(int x0, int y0, int x1, int y1) const {
+        return anyInRows(rows, (x0 < 0) ? 0 : x0, (y0 < 0) ? 0 : y0,
+                         (x1 >= W) ? W - 1 : x1, (y1 >= H) ? H - 1 : y1);
+    }
+};
+
+// Any other board within one chunk
+class SmallShape {
+private:
+    const uint64_t* rows;
+    int w, h;
+
+public:
+    explicit SmallShape(const BrickGrid& grid)
+        : rows(grid.rowMasks(0, 0)), w(grid.getWidth()), h(grid.getHeight()) {}
+    
+    static bool fits(const BrickGrid& grid) {
+        return grid.getWidth() <= BrickGrid::CHUNK_SIZE && grid.getHeight() <= BrickGrid::CHUNK_SIZE;
+    }
+    
+    int width() const { return w; }
+    int height() const { return h; }
+    bool brickAt(int x, int y) const {
+        return static_cast<unsigned>(x) < static_cast<unsigned>(w) &&
+               static_cast<unsigned>(y) < static_cast<unsigned>(h) && ((rows[y] >> x) & 1);
+    }
+    bool anyInRect(int x0, int y0, int x1, int y1) const {
+        return anyInRows(rows, (x0 < 0) ? 0 : x0, (y0 < 0) ? 0 : y0,
+                         (x1 >= w) ? w - 1 : x1, (y1 >= h) ? h - 1 : y1);
+    }
+};
+
+// Everything larger goes through the chunk table
+class ChunkedShape {
+private:
+    const BrickGrid& grid;
+
+public:
+    explicit ChunkedShape(const BrickGrid& grid) : grid(grid) {}
+    
+    int width() const { return grid.getWidth(); }
+    int height() const { return grid.getHeight(); }
+    bool brickAt(int x, int y) const { return grid.inside(x, y) && grid.occupied(x, y); }
+    bool anyInRect(int x0, int y0, int x1, int y1) const { return grid.anyInRect(x0, y0, x1, y1); }
+};
+
+
+constexpr uint64_t shapeKey(int width, int height) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(width)) << 32) | static_cast<uint32_t>(height);
+}
+
+// Calls visit(shape) with the fastest shape for the grid. Each size listed
+// here is one more copy of the collision code, so the list stays short: the
+// default board, then square endgames across the 8..20 range the endgame
+// editor is meant for. Anything else takes SmallShape or ChunkedShape.
+template <class Visitor>
+typename Visitor::result_type visitShape(const BrickGrid& grid, const Visitor& visit) {
+    switch (shapeKey(grid.getWidth(), grid.getHeight())) {
+        case shapeKey(9, 18): return visit(FixedShape<9, 18>(grid));
+        case shapeKey(8, 8): return visit(FixedShape<8, 8>(grid));
+        case shapeKey(10, 10): return visit(FixedShape<10, 10>(grid));
+        case shapeKey(12, 12): return visit(FixedShape<12, 12>(grid));
+        case shapeKey(16, 16): return visit(FixedShape<16, 16>(grid));
+        case shapeKey(20, 20): return visit(FixedShape<20, 20>(grid));
+        default: break;
+    }
+    if (SmallShape::fits(grid)) {
+        return visit(SmallShape(grid));
+    }
+    return visit(ChunkedShape(grid));
+}
+
+#endif
\ No newline at end of file
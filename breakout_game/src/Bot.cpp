@@ -0,0 +1,39 @@
+#include "Bot.h"
+#include <cmath>
+
+Bot::Bot(uint64_t seed) : rng(seed), offset(1.5), rising(false) {}
+
+Input Bot::decide(const Simulation& sim) {
+    Input input;
+    if (sim.getBall().attached) {
+        predictor.clear();
+        input.launch = true;
+        return input;
+    }
+    
+    // Follow the lowest falling ball, or the first one if none is falling
+    const BallStore& balls = sim.getBalls();
+    size_t chosen = 0;
+    for (size_t i = 1; i < balls.size(); i++) {
+        if (balls.dy[i] > 0 && (balls.dy[chosen] <= 0 || balls.y[i] > balls.y[chosen])) {
+            chosen = i;
+        }
+    }
+    Ball ball = balls.get(chosen);
+    
+    if (ball.dy < 0 && !rising) {
+        offset = rng.unit() * sim.getPaddleWidth();
+    }
+    rising = ball.dy < 0;
+    
+    // Without a prediction, e.g. a ball wedged between bricks, just follow it
+    double landingX, ticks;
+    double aim = predictor.predict(sim, ball, landingX, ticks) ? landingX : ball.x;
+    int target = static_cast<int>(std::floor(aim - offset + 0.5));
+    if (target < sim.getPaddleX()) {
+        input.move = -1;
+    } else if (target > sim.getPaddleX()) {
+        input.move = 1;
+    }
+    return input;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "Simulation.h"
+#include "TrajectoryPredictor.h"
+#include "Rng.h"
+
+// Paddle player for headless runs and the in-game autopilot: heads for
+// where the lowest falling ball will come down and picks a random contact
+// point for every return so games don't settle into a loop
+class Bot {
+private:
+    Rng rng;
+    double offset;      // where on the paddle to take the next hit
+    bool rising;
+    TrajectoryPredictor predictor;
+    
+public:
+    explicit Bot(uint64_t seed);
+    
+    Input decide(const Simulation& sim);
+};
+
+#endif
\ No newline at end of file
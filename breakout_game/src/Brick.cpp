@@ -1,5 +1,56 @@
 #include "Brick.h"
 
-Brick::Brick(int x, int y, BrickType type) : x(x), y(y), type(type) {
-    durability = (type == BrickType::DURABLE) ? 3 : 1;
+namespace {
+
+const BrickType TYPE_BY_CODE[4] = {
+    BrickType::EMPTY, BrickType::NORMAL, BrickType::DURABLE, BrickType::INDESTRUCTIBLE
+};
+
+uint8_t codeOf(BrickType type) {
+    switch (type) {
+        case BrickType::NORMAL: return 1;
+        case BrickType::DURABLE: return 2;
+        case BrickType::INDESTRUCTIBLE: return 3;
+        default: return 0;
+    }
+}
+
+}
+
+const uint32_t Brick::VALID_BYTES;
+
+Brick::Brick(BrickType type) {
+    uint8_t code = codeOf(type);
+    int durability = (type == BrickType::DURABLE) ? 3 : 1;
+    bits = code ? static_cast<uint8_t>(code | (durability << 2)) : 0;
+}
+
+BrickType Brick::type() const {
+    return TYPE_BY_CODE[bits & 3];
+}
+
+int Brick::hit() {
+    switch (bits & 3) {
+        case 1:
+            bits = 0;
+            return 10;
+        case 2:
+            bits -= 1 << 2;
+            if (durability() <= 0) {
+                bits = 0;
+            }
+            return 5;
+        default:
+            // INDESTRUCTIBLE bricks don't break
+            return 0;
+    }
+}
+
+bool Brick::fromSymbol(char symbol, BrickType& type) {
+    switch (symbol) {
+        case '@': type = BrickType::NORMAL; return true;
+        case '#': type = BrickType::DURABLE; return true;
+        case '*': type = BrickType::INDESTRUCTIBLE; return true;
+        default: return false;
+    }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef BRICK_H
 #define BRICK_H
 
+#include <cstdint>
+
 enum class BrickType {
     EMPTY = ' ',
     NORMAL = '@',
@@ -8,12 +10,33 @@ enum class BrickType {
     INDESTRUCTIBLE = '*'
 };
 
+// One board cell packed into a byte: bits 0-1 hold the type code,
+// bits 2-7 the remaining durability. A zero byte is an empty cell.
 struct Brick {
-    int x, y;
-    BrickType type;
-    int durability;
+    // Bit b is set for every byte b a cell may hold: empty, NORMAL and
+    // INDESTRUCTIBLE at durability 1, DURABLE at 1-3
+    static const uint32_t VALID_BYTES = (1u << 0x00) | (1u << 0x05) | (1u << 0x07) |
+                                        (1u << 0x06) | (1u << 0x0A) | (1u << 0x0E);
+    
+    uint8_t bits;
+    
+    Brick() : bits(0) {}
+    explicit Brick(BrickType type);
     
-    Brick(int x, int y, BrickType type);
+    BrickType type() const;
+    int durability() const { return bits >> 2; }
+    bool empty() const { return bits == 0; }
+    bool breakable() const { return (bits & 3) == 1 || (bits & 3) == 2; }
+    // True for bytes a board can actually hold: empty, or a type with a
+    // durability it can have. Loaders reject anything else.
+    bool valid() const { return bits < 16 && ((VALID_BYTES >> bits) & 1); }
+    
+    // Applies one ball hit and returns the score it is worth
+    int hit();
+    
+    static bool fromSymbol(char symbol, BrickType& type);
 };
 
+static_assert(sizeof(Brick) == 1, "boards and endgame files store one byte per cell");
+
 #endif
\ No newline at end of file
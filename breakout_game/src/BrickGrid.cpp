@@ -0,0 +1,336 @@
+#include "BrickGrid.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint64_t FNV_PRIME = 1099511628211ULL;
+const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+// Row masks of a chunk that isn't stored
+const uint64_t NO_MASKS[BrickGrid::CHUNK_SIZE] = {};
+
+// Occupancy of a chunk row, bit i set for a non-empty cell i. Works on
+// eight cells per word without branching, as boards loaded from files are
+// too irregular for a per-cell branch to predict.
+uint64_t occupancy(const Brick* row) {
+    const uint64_t LOW7 = 0x7F7F7F7F7F7F7F7FULL;
+    const uint64_t HIGH = 0x8080808080808080ULL;
+    uint64_t mask = 0;
+    for (int i = 0; i < BrickGrid::CHUNK_SIZE; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, row + i, 8);
+        // High bit of each byte set when the byte is non-zero, then the
+        // eight high bits gathered into the top byte
+        uint64_t nonZero = (((word & LOW7) + LOW7) | word) & HIGH;
+        mask |= ((nonZero * 0x0002040810204081ULL) >> 56) << i;
+    }
+    return mask;
+}
+
+// Streaming form of BrickGrid::checksum(bytes, count): bytes are gathered
+// into 8-byte words, and a run of zero words is one multiplication by a
+// power of the prime, so empty space is skipped rather than hashed
+struct DenseHash {
+    uint64_t hash;
+    unsigned char word[8];
+    int filled;
+    
+    DenseHash() : hash(FNV_OFFSET), filled(0) {}
+    
+    void flushWord() {
+        uint64_t value;
+        std::memcpy(&value, word, 8);
+        hash = (hash ^ value) * FNV_PRIME;
+        filled = 0;
+    }
+    
+    void add(const unsigned char* bytes, size_t count) {
+        size_t i = 0;
+        for (; i < count && filled != 0; i++) {
+            word[filled++] = bytes[i];
+            if (filled == 8) flushWord();
+        }
+        // Whole words straight from the input once aligned to the stream
+        for (; i + 8 <= count; i += 8) {
+            uint64_t value;
+            std::memcpy(&value, bytes + i, 8);
+            hash = (hash ^ value) * FNV_PRIME;
+        }
+        for (; i < count; i++) {
+            word[filled++] = bytes[i];
+        }
+    }
+    
+    void addZeros(uint64_t count) {
+        while (filled != 0 && count > 0) {
+            word[filled++] = 0;
+            count--;
+            if (filled == 8) flushWord();
+        }
+        uint64_t words = count / 8;
+        uint64_t factor = 1;
+        uint64_t base = FNV_PRIME;
+        for (uint64_t n = words; n; n >>= 1) {
+            if (n & 1) factor *= base;
+            base *= base;
+        }
+        hash *= factor;
+        for (count -= words * 8; count > 0; count--) {
+            word[filled++] = 0;
+        }
+    }
+    
+    // The bytes after the last whole word are hashed one at a time
+    uint32_t finish() {
+        for (int i = 0; i < filled; i++) {
+            hash = (hash ^ word[i]) * FNV_PRIME;
+        }
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+};
+
+}
+
+const int BrickGrid::CHUNK_SHIFT;
+const int BrickGrid::CHUNK_SIZE;
+const int BrickGrid::CHUNK_MASK;
+const int BrickGrid::CHUNK_CELLS;
+const int BrickGrid::CHUNK_RECORD;
+const int32_t BrickGrid::NO_CHUNK;
+
+BrickGrid::BrickGrid() : width(0), height(0), chunksX(0), chunksY(0) {}
+
+BrickGrid::BrickGrid(int width, int height) : width(0), height(0), chunksX(0), chunksY(0) {
+    resize(width, height);
+}
+
+void BrickGrid::resize(int w, int h) {
+    width = w;
+    height = h;
+    chunksX = (w + CHUNK_MASK) >> CHUNK_SHIFT;
+    chunksY = (h + CHUNK_MASK) >> CHUNK_SHIFT;
+    slots.assign(static_cast<size_t>(chunksX) * chunksY, NO_CHUNK);
+    cells.clear();
+    masks.clear();
+}
+
+void BrickGrid::clear() {
+    std::fill(slots.begin(), slots.end(), NO_CHUNK);
+    cells.clear();
+    masks.clear();
+}
+
+void BrickGrid::assignDense(const Brick* dense, int w, int h) {
+    resize(w, h);
+    for (int cy = 0; cy < chunksY; cy++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            int x0 = cx << CHUNK_SHIFT;
+            int y0 = cy << CHUNK_SHIFT;
+            int cols = std::min(CHUNK_SIZE, w - x0);
+            int rows = std::min(CHUNK_SIZE, h - y0);
+            
+            Brick* target = nullptr;
+            for (int r = 0; r < rows; r++) {
+                const Brick* source = dense + static_cast<size_t>(y0 + r) * w + x0;
+                for (int c = 0; c < cols; c++) {
+                    if (source[c].empty()) continue;
+                    if (!target) target = addChunk(cx, cy);
+                    target[(r << CHUNK_SHIFT) + c] = source[c];
+                }
+            }
+        }
+    }
+    reindex();
+}
+
+const uint64_t* BrickGrid::rowMasks(int cx, int cy) const {
+    int32_t index = slots[static_cast<size_t>(cy) * chunksX + cx];
+    return (index == NO_CHUNK) ? NO_MASKS : &masks[static_cast<size_t>(index) * CHUNK_SIZE];
+}
+
+const Brick* BrickGrid::chunk(int cx, int cy) const {
+    int32_t index = slots[static_cast<size_t>(cy) * chunksX + cx];
+    return (index == NO_CHUNK) ? nullptr : &cells[static_cast<size_t>(index) * CHUNK_CELLS];
+}
+
+Brick* BrickGrid::addChunk(int cx, int cy) {
+    int32_t& index = slots[static_cast<size_t>(cy) * chunksX + cx];
+    if (index == NO_CHUNK) {
+        index = static_cast<int32_t>(chunkCount());
+        cells.resize(cells.size() + CHUNK_CELLS);
+        masks.resize(masks.size() + CHUNK_SIZE, 0);
+    }
+    return &cells[static_cast<size_t>(index) * CHUNK_CELLS];
+}
+
+void BrickGrid::reindex() {
+    for (size_t row = 0; row < masks.size(); row++) {
+        masks[row] = occupancy(&cells[row * CHUNK_SIZE]);
+    }
+}
+
+void BrickGrid::appendChunks(std::string& out) const {
+    size_t countAt = out.size();
+    uint32_t count = 0;
+    out.append(reinterpret_cast<const char*>(&count), 4);
+    
+    for (int cy = 0; cy < chunksY; cy++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            int32_t index = slots[static_cast<size_t>(cy) * chunksX + cx];
+            if (index == NO_CHUNK) continue;
+            // Chunks emptied by play are left out
+            const uint64_t* mask = &masks[static_cast<size_t>(index) * CHUNK_SIZE];
+            if (std::find_if(mask, mask + CHUNK_SIZE, [](uint64_t m) { return m != 0; }) ==
+                mask + CHUNK_SIZE) {
+                continue;
+            }
+            uint32_t position[2] = { static_cast<uint32_t>(cx), static_cast<uint32_t>(cy) };
+            out.append(reinterpret_cast<const char*>(position), 8);
+            out.append(reinterpret_cast<const char*>(&cells[static_cast<size_t>(index) * CHUNK_CELLS]),
+                       CHUNK_CELLS);
+            count++;
+        }
+    }
+    std::memcpy(&out[countAt], &count, 4);
+}
+
+size_t BrickGrid::readChunks(const unsigned char* data, size_t size) {
+    uint32_t count;
+    if (size < 4) return 0;
+    std::memcpy(&count, data, 4);
+    if (count > slots.size() || (size - 4) / CHUNK_RECORD < count) return 0;
+    
+    cells.reserve(cells.size() + static_cast<size_t>(count) * CHUNK_CELLS);
+    masks.reserve(masks.size() + static_cast<size_t>(count) * CHUNK_SIZE);
+    const unsigned char* p = data + 4;
+    for (uint32_t i = 0; i < count; i++, p += CHUNK_RECORD) {
+        uint32_t position[2];
+        std::memcpy(position, p, 8);
+        if (position[0] >= static_cast<uint32_t>(chunksX) || position[1] >= static_cast<uint32_t>(chunksY)) {
+            return 0;
+        }
+        int cx = position[0];
+        int cy = position[1];
+        Brick* target = addChunk(cx, cy);
+        std::memcpy(target, p + 8, CHUNK_CELLS);
+        
+        // Nothing may sit past the board edge in the last row or column
+        int cols = std::min(CHUNK_SIZE, width - (cx << CHUNK_SHIFT));
+        int rows = std::min(CHUNK_SIZE, height - (cy << CHUNK_SHIFT));
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            int from = (r < rows) ? cols : 0;
+            std::fill(target + (r << CHUNK_SHIFT) + from, target + ((r + 1) << CHUNK_SHIFT), Brick());
+        }
+        // One test per chunk; a branch per cell costs more than the copy
+        bool valid = true;
+        for (int c = 0; c < CHUNK_CELLS; c++) {
+            valid &= target[c].valid();
+        }
+        if (!valid) return 0;
+    }
+    reindex();
+    return p - data;
+}
+
+void BrickGrid::set(int x, int y, BrickType type) {
+    size_t slot = chunkIndex(x, y);
+    if (slots[slot] == NO_CHUNK) {
+        if (type == BrickType::EMPTY) return;
+        addChunk(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT);
+    }
+    size_t base = static_cast<size_t>(slots[slot]);
+    cells[base * CHUNK_CELLS + ((y & CHUNK_MASK) << CHUNK_SHIFT) + (x & CHUNK_MASK)] =
+        (type == BrickType::EMPTY) ? Brick() : Brick(type);
+    uint64_t bit = 1ULL << (x & CHUNK_MASK);
+    uint64_t& mask = masks[base * CHUNK_SIZE + (y & CHUNK_MASK)];
+    mask = (type == BrickType::EMPTY) ? (mask & ~bit) : (mask | bit);
+}
+
+int BrickGrid::hit(int x, int y) {
+    int32_t index = slots[chunkIndex(x, y)];
+    if (index == NO_CHUNK) return 0;
+    size_t base = static_cast<size_t>(index);
+    Brick& brick = cells[base * CHUNK_CELLS + ((y & CHUNK_MASK) << CHUNK_SHIFT) + (x & CHUNK_MASK)];
+    int points = brick.hit();
+    if (brick.empty()) {
+        masks[base * CHUNK_SIZE + (y & CHUNK_MASK)] &= ~(1ULL << (x & CHUNK_MASK));
+    }
+    return points;
+}
+
+bool BrickGrid::anyInRect(int x0, int y0, int x1, int y1) const {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= width) x1 = width - 1;
+    if (y1 >= height) y1 = height - 1;
+    if (x0 > x1 || y0 > y1) return false;
+    
+    for (int cy = y0 >> CHUNK_SHIFT; cy <= (y1 >> CHUNK_SHIFT); cy++) {
+        int rowStart = cy << CHUNK_SHIFT;
+        int firstRow = std::max(y0 - rowStart, 0);
+        int lastRow = std::min(y1 - rowStart, static_cast<int>(CHUNK_MASK));
+        for (int cx = x0 >> CHUNK_SHIFT; cx <= (x1 >> CHUNK_SHIFT); cx++) {
+            int32_t index = slots[static_cast<size_t>(cy) * chunksX + cx];
+            if (index == NO_CHUNK) continue;
+            
+            int colStart = cx << CHUNK_SHIFT;
+            uint64_t columns = ~0ULL;
+            if (x0 > colStart) columns &= ~0ULL << (x0 - colStart);
+            if (x1 < colStart + CHUNK_MASK) columns &= ~0ULL >> (CHUNK_MASK - (x1 - colStart));
+            const uint64_t* mask = &masks[static_cast<size_t>(index) * CHUNK_SIZE];
+            for (int r = firstRow; r <= lastRow; r++) {
+                if (mask[r] & columns) return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Walks the dense byte order: row by row, the stored chunks' cells in
+// between runs of zeros
+uint32_t BrickGrid::checksum() const {
+    DenseHash hash;
+    uint64_t done = 0;      // dense bytes hashed so far
+    for (int cy = 0; cy < chunksY; cy++) {
+        const int32_t* slot = &slots[static_cast<size_t>(cy) * chunksX];
+        bool any = false;
+        for (int cx = 0; cx < chunksX && !any; cx++) {
+            any = (slot[cx] != NO_CHUNK);
+        }
+        if (!any) continue;
+        
+        int rowStart = cy << CHUNK_SHIFT;
+        int rows = std::min(CHUNK_SIZE, height - rowStart);
+        for (int r = 0; r < rows; r++) {
+            uint64_t lineStart = static_cast<uint64_t>(rowStart + r) * width;
+            for (int cx = 0; cx < chunksX; cx++) {
+                if (slot[cx] == NO_CHUNK) continue;
+                uint64_t start = lineStart + (cx << CHUNK_SHIFT);
+                int cols = std::min(CHUNK_SIZE, width - (cx << CHUNK_SHIFT));
+                hash.addZeros(start - done);
+                hash.add(reinterpret_cast<const unsigned char*>(
+                             &cells[static_cast<size_t>(slot[cx]) * CHUNK_CELLS + (r << CHUNK_SHIFT)]),
+                         cols);
+                done = start + cols;
+            }
+        }
+    }
+    hash.addZeros(area() - done);
+    return hash.finish();
+}
+
+// FNV-1a over 8-byte words, folded to 32 bits
+uint32_t BrickGrid::checksum(const unsigned char* bytes, size_t count) {
+    uint64_t hash = FNV_OFFSET;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < count; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
\ No newline at end of file
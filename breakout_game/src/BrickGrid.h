@@ -0,0 +1,159 @@
+#ifndef BRICKGRID_H
+#define BRICKGRID_H
+
+#include "Brick.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Board coordinate, used for dirty-cell lists
+struct Cell {
+    int x, y;
+    
+    Cell(int x, int y) : x(x), y(y) {}
+};
+
+// Board of packed bricks split into CHUNK_SIZE x CHUNK_SIZE chunks. A chunk
+// is only stored once a brick is placed in it, so empty regions cost one
+// table slot per chunk and memory follows the occupied area. Each chunk row
+// has a bitmask of its occupied cells, so area queries skip empty space 64
+// cells at a time. Copies reuse the destination's storage.
+class BrickGrid {
+public:
+    static const int CHUNK_SHIFT = 6;
+    static const int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static const int CHUNK_MASK = CHUNK_SIZE - 1;
+    static const int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+    // Serialized chunk: uint32 cx, uint32 cy, then the cells
+    static const int CHUNK_RECORD = 8 + CHUNK_CELLS;
+
+private:
+    static const int32_t NO_CHUNK = -1;
+    
+    int width, height;
+    int chunksX, chunksY;
+    std::vector<int32_t> slots;     // chunksY * chunksX, index of each stored chunk or NO_CHUNK
+    std::vector<Brick> cells;       // CHUNK_CELLS per stored chunk, row-major within it
+    std::vector<uint64_t> masks;    // CHUNK_SIZE per stored chunk, one word per chunk row
+
+public:
+    BrickGrid();
+    BrickGrid(int width, int height);
+    
+    // Empties the board at the new size; storage is kept for reuse
+    void resize(int w, int h);
+    void clear();
+    // Copies a dense row-major board, storing only chunks that hold bricks
+    void assignDense(const Brick* dense, int w, int h);
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    size_t area() const { return static_cast<size_t>(width) * height; }
+    bool inside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+    
+    Brick at(int x, int y) const {
+        int32_t chunk = slots[chunkIndex(x, y)];
+        if (chunk == NO_CHUNK) return Brick();
+        return cells[static_cast<size_t>(chunk) * CHUNK_CELLS + ((y & CHUNK_MASK) << CHUNK_SHIFT) +
+                     (x & CHUNK_MASK)];
+    }
+    void set(int x, int y, BrickType type);
+    // Applies one ball hit to the brick at (x, y) and returns its score
+    int hit(int x, int y);
+    
+    bool occupied(int x, int y) const {
+        int32_t chunk = slots[chunkIndex(x, y)];
+        return chunk != NO_CHUNK &&
+               ((masks[static_cast<size_t>(chunk) * CHUNK_SIZE + (y & CHUNK_MASK)] >> (x & CHUNK_MASK)) & 1);
+    }
+    // True if any cell in the inclusive rectangle holds a brick; the
+    // rectangle is clipped to the board
+    bool anyInRect(int x0, int y0, int x1, int y1) const;
+    
+    // Calls f(x, y, brick) for every brick in the inclusive rectangle, row
+    // by row. Only stored chunks are looked at.
+    template <class F>
+    void forEachBrickIn(int x0, int y0, int x1, int y1, F f) const;
+    template <class F>
+    void forEachBrick(F f) const { forEachBrickIn(0, 0, width - 1, height - 1, f); }
+    
+    // Occupancy of chunk (cx, cy), one mask per chunk row with bit i for
+    // column i; all zero when the chunk isn't stored. Hits keep it current,
+    // placing a brick may move it.
+    const uint64_t* rowMasks(int cx, int cy) const;
+    
+    // Raw chunk access for the file formats. Chunk (cx, cy) covers cells
+    // from (cx, cy) * CHUNK_SIZE; cells past the board edge stay empty.
+    int getChunksX() const { return chunksX; }
+    int getChunksY() const { return chunksY; }
+    size_t chunkCount() const { return masks.size() / CHUNK_SIZE; }
+    // Null when the chunk isn't stored
+    const Brick* chunk(int cx, int cy) const;
+    // Stores the chunk if needed; call reindex() after writing through it
+    Brick* addChunk(int cx, int cy);
+    // Rebuilds the occupancy masks from the cells
+    void reindex();
+    
+    // Sparse form shared by binary endgames and replays: a uint32 chunk
+    // count, then one CHUNK_RECORD per chunk that holds bricks. Host byte
+    // order.
+    void appendChunks(std::string& out) const;
+    // Reads appendChunks() output into a grid already resized to the board.
+    // Returns the bytes used, or 0 when the data is truncated, a chunk lies
+    // outside the board or a cell isn't a valid brick.
+    size_t readChunks(const unsigned char* data, size_t size);
+    
+    // FNV-1a style hash of the board as dense row-major bytes. Runs of empty
+    // cells are folded in without visiting them, so the cost follows the
+    // stored chunks; the value matches checksum() over the dense bytes.
+    uint32_t checksum() const;
+    static uint32_t checksum(const unsigned char* bytes, size_t count);
+
+private:
+    size_t chunkIndex(int x, int y) const {
+        return static_cast<size_t>(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT);
+    }
+};
+
+template <class F>
+void BrickGrid::forEachBrickIn(int x0, int y0, int x1, int y1, F f) const {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= width) x1 = width - 1;
+    if (y1 >= height) y1 = height - 1;
+    if (x0 > x1 || y0 > y1) return;
+    
+    int firstChunkX = x0 >> CHUNK_SHIFT;
+    int lastChunkX = x1 >> CHUNK_SHIFT;
+    for (int cy = y0 >> CHUNK_SHIFT; cy <= (y1 >> CHUNK_SHIFT); cy++) {
+        const int32_t* slot = &slots[static_cast<size_t>(cy) * chunksX];
+        bool stored = false;
+        for (int cx = firstChunkX; cx <= lastChunkX && !stored; cx++) {
+            stored = (slot[cx] != NO_CHUNK);
+        }
+        if (!stored) continue;
+        
+        int rowStart = cy << CHUNK_SHIFT;
+        int firstRow = (y0 > rowStart) ? y0 - rowStart : 0;
+        int lastRow = (y1 < rowStart + CHUNK_MASK) ? y1 - rowStart : CHUNK_MASK;
+        for (int r = firstRow; r <= lastRow; r++) {
+            for (int cx = firstChunkX; cx <= lastChunkX; cx++) {
+                if (slot[cx] == NO_CHUNK) continue;
+                size_t base = static_cast<size_t>(slot[cx]);
+                uint64_t mask = masks[base * CHUNK_SIZE + r];
+                int colStart = cx << CHUNK_SHIFT;
+                if (x0 > colStart) mask &= ~0ULL << (x0 - colStart);
+                if (x1 < colStart + CHUNK_MASK) mask &= ~0ULL >> (CHUNK_MASK - (x1 - colStart));
+                const Brick* row = &cells[base * CHUNK_CELLS + (r << CHUNK_SHIFT)];
+                while (mask) {
+                    int c = __builtin_ctzll(mask);
+                    mask &= mask - 1;
+                    f(colStart + c, rowStart + r, row[c]);
+                }
+            }
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -2,14 +2,20 @@
 #include "Utils.h"
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
-Config::Config() : filename("default"), ballSpeed(5), randomSeed(-1), initialLevel(1) {}
+Config::Config() : filename("default"), ballSpeed(5), randomSeed(-1), initialLevel(1),
+                   tickRate(60), maxFps(30), multiBall(10), fixedPoint(false) {}
 
 void Config::loadDefault() {
     filename = "default";
     ballSpeed = 5;
     randomSeed = -1;
     initialLevel = 1;
+    tickRate = 60;
+    maxFps = 30;
+    multiBall = 10;
+    fixedPoint = false;
 }
 
 bool Config::loadFromFile(const std::string& fname) {
@@ -25,19 +31,25 @@ bool Config::loadFromFile(const std::string& fname) {
     file >> randomSeed;
     file >> initialLevel;
     
+    // Timing settings were added later; older files keep the defaults
+    if (!(file >> tickRate) || tickRate <= 0) tickRate = 60;
+    if (!(file >> maxFps) || maxFps <= 0) maxFps = 30;
+    if (!(file >> multiBall) || multiBall < 0 || multiBall > 100) multiBall = 10;
+    if (!(file >> fixedPoint)) fixedPoint = false;
+    
     file.close();
     return true;
 }
 
-void Config::saveToFile() {
+bool Config::saveToFile() const {
     Utils::createDirectory("config");
-    std::string path = "config/" + filename + ".config";
-    std::ofstream file(path);
-    
-    if (file.is_open()) {
-        file << ballSpeed << std::endl;
-        file << randomSeed << std::endl;
-        file << initialLevel << std::endl;
-        file.close();
-    }
+    std::ostringstream text;
+    text << ballSpeed << "\n";
+    text << randomSeed << "\n";
+    text << initialLevel << "\n";
+    text << tickRate << "\n";
+    text << maxFps << "\n";
+    text << multiBall << "\n";
+    text << fixedPoint << "\n";
+    return Utils::writeFileAtomic("config/" + filename + ".config", text.str());
 }
\ No newline at end of file
@@ -5,14 +5,18 @@
 
 struct Config {
     std::string filename;
-    int ballSpeed;
+    int ballSpeed;      // cells per second
     int randomSeed;
     int initialLevel;
+    int tickRate;       // physics updates per second
+    int maxFps;         // render cap
+    int multiBall;      // percent chance a destroyed brick splits the ball
+    bool fixedPoint;    // integer physics, identical games on every build
     
     Config();
     void loadDefault();
     bool loadFromFile(const std::string& filename);
-    void saveToFile();
+    bool saveToFile() const;
 };
 
 #endif
\ No newline at end of file
@@ -1,75 +1,226 @@
 #include "EndGame.h"
+#include "MappedFile.h"
 #include "Utils.h"
-#include <fstream>
 #include <sstream>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <sys/stat.h>
 
-EndGame::EndGame() : filename("empty"), width(9), height(18), initialLevel(1) {}
+namespace {
+
+// Binary endgame layout: this header, then at headerSize the cells. Version
+// 1 stores width * height packed Brick bytes in row-major order; version 2
+// stores only the chunks holding bricks, as BrickGrid::appendChunks() writes
+// them. Fields are stored in host byte order.
+struct BinaryHeader {
+    char magic[4];          // "BKEG"
+    uint16_t version;
+    uint16_t headerSize;    // offset of the cell data
+    uint32_t width;
+    uint32_t height;
+    int32_t initialLevel;
+    uint32_t checksum;      // BrickGrid::checksum() of the board
+};
+
+const char BINARY_MAGIC[4] = { 'B', 'K', 'E', 'G' };
+const uint16_t BINARY_VERSION = 2;
+
+// Cursor over a text endgame. Parses in place, so loading a board does not
+// allocate per line.
+struct TextReader {
+    const char* p;
+    const char* end;
+    
+    void skipBlanks() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    }
+    
+    void skipSpace() {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;
+    }
+    
+    void nextLine() {
+        while (p < end && *p != '\n') p++;
+        if (p < end) p++;
+    }
+    
+    bool readInt(int& value) {
+        skipBlanks();
+        bool negative = (p < end && *p == '-');
+        if (negative || (p < end && *p == '+')) p++;
+        if (p == end || !std::isdigit(static_cast<unsigned char>(*p))) return false;
+        long result = 0;
+        while (p < end && std::isdigit(static_cast<unsigned char>(*p))) {
+            if (result < 100000000) result = result * 10 + (*p - '0');
+            p++;
+        }
+        value = static_cast<int>(negative ? -result : result);
+        return true;
+    }
+    
+    bool readChar(char& c) {
+        skipBlanks();
+        if (p == end || *p == '\n') return false;
+        c = *p++;
+        return true;
+    }
+};
+
+bool modifiedTime(const std::string& path, int64_t& mtime) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+
+}
+
+const int EndGame::MAX_SIZE;
+
+EndGame::EndGame() : filename("empty"), width(9), height(18), initialLevel(1), bricks(9, 18) {}
 
 void EndGame::loadEmpty(int w, int h) {
     filename = "empty";
     width = w;
     height = h;
     initialLevel = 1;
-    bricks.clear();
+    bricks.resize(w, h);
 }
 
 bool EndGame::loadFromFile(const std::string& fname) {
-    std::string path = "endgames/" + fname + ".end";
-    std::ifstream file(path);
-    
-    if (!file.is_open()) {
+    std::string base = "endgames/" + fname;
+    bool binary;
+    if (!resolve(base, binary)) return false;
+    bool loaded = binary ? loadBinary(base + ".endb") : loadText(base + ".end");
+    if (loaded) {
+        filename = fname;
+    }
+    return loaded;
+}
+
+bool EndGame::loadText(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
         return false;
     }
     
-    filename = fname;
-    bricks.clear();
-    
-    file >> width >> height;
-    file >> initialLevel;
+    TextReader text = { reinterpret_cast<const char*>(file.data()),
+                        reinterpret_cast<const char*>(file.data()) + file.size() };
+    int w, h, level;
+    text.skipSpace();
+    if (!text.readInt(w)) return false;
+    text.skipSpace();
+    if (!text.readInt(h)) return false;
+    text.skipSpace();
+    if (!text.readInt(level) || level < 1 || w <= 0 || h <= 0 || w > MAX_SIZE || h > MAX_SIZE) return false;
+    width = w;
+    height = h;
+    initialLevel = level;
+    // Reuses the grid's storage when the size hasn't changed
+    bricks.resize(width, height);
     
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
+    // One "P x y symbol" per line; anything else is skipped
+    for (text.nextLine(); text.p < text.end; text.nextLine()) {
+        char command, symbol;
+        int x, y;
+        if (!text.readChar(command) || command != 'P') continue;
+        if (!text.readInt(x) || !text.readInt(y) || !text.readChar(symbol)) continue;
         
-        std::istringstream iss(line);
-        char command;
-        iss >> command;
+        BrickType type;
+        if (!Brick::fromSymbol(symbol, type)) continue;
+        if (!bricks.inside(x, y)) continue;
         
-        if (command == 'P') {
-            int x, y;
-            char typeChar;
-            iss >> x >> y >> typeChar;
-            
-            BrickType type;
-            switch (typeChar) {
-                case '@': type = BrickType::NORMAL; break;
-                case '#': type = BrickType::DURABLE; break;
-                case '*': type = BrickType::INDESTRUCTIBLE; break;
-                default: continue;
-            }
-            
-            bricks.emplace_back(x, y, type);
-        }
+        bricks.set(x, y, type);
     }
-    
-    file.close();
     return true;
 }
 
-void EndGame::saveToFile() {
+bool EndGame::saveToFile() const {
     Utils::createDirectory("endgames");
-    std::string path = "endgames/" + filename + ".end";
-    std::ofstream file(path);
+    return saveText("endgames/" + filename + ".end");
+}
+
+bool EndGame::saveText(const std::string& path) const {
+    return Utils::writeFileAtomic(path, toText());
+}
+
+std::string EndGame::toText() const {
+    std::ostringstream text;
+    text << width << " " << height << "\n";
+    text << initialLevel << "\n";
     
-    if (file.is_open()) {
-        file << width << " " << height << std::endl;
-        file << initialLevel << std::endl;
-        
-        for (const auto& brick : bricks) {
-            file << "P " << brick.x << " " << brick.y << " " 
-                 << static_cast<char>(brick.type) << std::endl;
+    bricks.forEachBrick([&text](int x, int y, Brick brick) {
+        text << "P " << x << " " << y << " " << static_cast<char>(brick.type()) << "\n";
+    });
+    return text.str();
+}
+
+bool EndGame::loadBinary(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(BinaryHeader)) {
+        return false;
+    }
+    
+    BinaryHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, BINARY_MAGIC, 4) != 0 ||
+        header.version == 0 || header.version > BINARY_VERSION ||
+        header.headerSize < sizeof(BinaryHeader) || file.size() < header.headerSize ||
+        header.width == 0 || header.width > static_cast<uint32_t>(MAX_SIZE) ||
+        header.height == 0 || header.height > static_cast<uint32_t>(MAX_SIZE) ||
+        header.initialLevel < 1) {
+        return false;
+    }
+    
+    const unsigned char* cells = file.data() + header.headerSize;
+    size_t available = file.size() - header.headerSize;
+    BrickGrid loaded;
+    if (header.version == 1) {
+        size_t cellCount = static_cast<size_t>(header.width) * header.height;
+        if (available < cellCount || BrickGrid::checksum(cells, cellCount) != header.checksum) {
+            return false;
+        }
+        const Brick* dense = reinterpret_cast<const Brick*>(cells);
+        for (size_t i = 0; i < cellCount; i++) {
+            if (!dense[i].valid()) return false;
+        }
+        loaded.assignDense(reinterpret_cast<const Brick*>(cells), header.width, header.height);
+    } else {
+        loaded.resize(header.width, header.height);
+        if (loaded.readChunks(cells, available) == 0 || loaded.checksum() != header.checksum) {
+            return false;
         }
-        
-        file.close();
     }
+    
+    width = header.width;
+    height = header.height;
+    initialLevel = header.initialLevel;
+    bricks = std::move(loaded);
+    return true;
+}
+
+bool EndGame::resolve(const std::string& base, bool& binary) {
+    int64_t binaryTime, textTime;
+    bool hasBinary = modifiedTime(base + ".endb", binaryTime);
+    bool hasText = modifiedTime(base + ".end", textTime);
+    binary = hasBinary && (!hasText || binaryTime >= textTime);
+    return hasBinary || hasText;
+}
+
+bool EndGame::saveBinary(const std::string& path) const {
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, 4);
+    header.version = BINARY_VERSION;
+    header.headerSize = sizeof(BinaryHeader);
+    header.width = bricks.getWidth();
+    header.height = bricks.getHeight();
+    header.initialLevel = initialLevel;
+    header.checksum = bricks.checksum();
+    
+    std::string contents;
+    contents.reserve(sizeof(header) + 4 + bricks.chunkCount() * BrickGrid::CHUNK_RECORD);
+    contents.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    bricks.appendChunks(contents);
+    return Utils::writeFileAtomic(path, contents);
 }
\ No newline at end of file
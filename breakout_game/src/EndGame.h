@@ -1,20 +1,39 @@
 #ifndef ENDGAME_H
 #define ENDGAME_H
 
-#include "Brick.h"  // 包含 Brick 定义
-#include <vector>
+#include "BrickGrid.h"
 #include <string>
 
 struct EndGame {
+    // Largest board side; boards are sparse, so size alone costs little
+    static const int MAX_SIZE = 10000;
+    
     std::string filename;
     int width, height;
     int initialLevel;
-    std::vector<Brick> bricks;
+    BrickGrid bricks;
     
     EndGame();
     void loadEmpty(int w, int h);
+    // Loads endgames/<name>.endb or endgames/<name>.end, see resolve()
     bool loadFromFile(const std::string& filename);
-    void saveToFile();
+    // Writes endgames/<name>.end, which then wins over an older .endb
+    bool saveToFile() const;
+    
+    bool loadText(const std::string& path);
+    bool saveText(const std::string& path) const;
+    std::string toText() const;
+    // Reads version 1 (dense) and 2 (sparse chunks); writes version 2. The
+    // file is mapped and its cells copied into the board's own chunks, so
+    // the board doesn't depend on the file afterwards; a load costs about
+    // one pass over the stored chunks, far less than parsing text
+    bool loadBinary(const std::string& path);
+    bool saveBinary(const std::string& path) const;
+    
+    // Which of <base>.endb and <base>.end holds the board: the one written
+    // last, so a save after a conversion wins; the binary one on a tie.
+    // False when neither exists.
+    static bool resolve(const std::string& base, bool& binary);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "EndGameLibrary.h"
+#include "Utils.h"
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace {
+
+const char* const INDEX_FILE = ".index";
+// First line of the index; an index without it is from an older layout and
+// is rebuilt
+const char* const INDEX_HEADER = "endgame-index 2";
+
+bool hasSuffix(const std::string& s, const std::string& suffix) {
+    return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool statFile(const std::string& path, int64_t& mtime, int64_t& size) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    size = info.st_size;
+    return true;
+}
+
+void countBricks(const BrickGrid& bricks, EndGameInfo& info) {
+    info.bricks = 0;
+    info.breakable = 0;
+    bricks.forEachBrick([&info](int, int, Brick brick) {
+        info.bricks++;
+        if (brick.breakable()) info.breakable++;
+    });
+}
+
+}
+
+EndGameLibrary::EndGameLibrary(const std::string& directory, size_t capacity)
+    : directory(directory), capacity(capacity ? capacity : 1), scanned(false) {}
+
+void EndGameLibrary::refresh() {
+    if (!scanned) {
+        loadIndex();
+        scanned = true;
+    }
+    
+    // Which file each name resolves to right now
+    std::map<std::string, bool> found;
+    DIR* dir = opendir(directory.c_str());
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string file = entry->d_name;
+            // Can't be written to the line-based index
+            if (file.find('\n') != std::string::npos) continue;
+            if (hasSuffix(file, ".endb")) {
+                found[file.substr(0, file.size() - 5)] = true;
+            } else if (hasSuffix(file, ".end")) {
+                found[file.substr(0, file.size() - 4)] = false;
+            }
+        }
+        closedir(dir);
+    }
+    // A name with both files goes by the loaders' rule
+    for (std::map<std::string, bool>::iterator it = found.begin(); it != found.end(); ++it) {
+        EndGame::resolve(directory + "/" + it->first, it->second);
+    }
+    
+    bool changed = false;
+    for (std::map<std::string, EndGameInfo>::iterator it = index.begin(); it != index.end();) {
+        if (found.count(it->first)) {
+            ++it;
+            continue;
+        }
+        forget(it->first);
+        index.erase(it++);
+        changed = true;
+    }
+    
+    for (std::map<std::string, bool>::const_iterator it = found.begin(); it != found.end(); ++it) {
+        const std::string& name = it->first;
+        std::string path = directory + "/" + name + (it->second ? ".endb" : ".end");
+        int64_t mtime, size;
+        if (!statFile(path, mtime, size)) continue;
+        
+        std::map<std::string, EndGameInfo>::iterator known = index.find(name);
+        if (known != index.end() && known->second.binary == it->second &&
+            known->second.mtime == mtime && known->second.size == size) {
+            continue;
+        }
+        
+        // The parsed board is dropped; caching every changed file would
+        // push out the boards that were actually played
+        EndGame board;
+        EndGameInfo info;
+        if (parse(name, it->second, board, info)) {
+            index[name] = info;
+        } else if (known != index.end()) {
+            forget(name);
+            index.erase(known);
+        }
+        changed = true;
+    }
+    
+    if (changed) saveIndex();
+}
+
+std::vector<EndGameInfo> EndGameLibrary::list() {
+    if (!scanned) refresh();
+    
+    std::vector<EndGameInfo> result;
+    result.reserve(index.size());
+    for (std::map<std::string, EndGameInfo>::const_iterator it = index.begin(); it != index.end(); ++it) {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+bool EndGameLibrary::load(const std::string& name, EndGame& out) {
+    std::string base = directory + "/" + name;
+    bool binary;
+    int64_t mtime, size;
+    if (!EndGame::resolve(base, binary) || !statFile(base + (binary ? ".endb" : ".end"), mtime, size)) {
+        forget(name);
+        return false;
+    }
+    
+    std::map<std::string, Cached>::iterator hit = cache.find(name);
+    if (hit != cache.end() && hit->second.binary == binary &&
+        hit->second.mtime == mtime && hit->second.size == size) {
+        recent.splice(recent.begin(), recent, hit->second.recent);
+        out = hit->second.board;
+        return true;
+    }
+    
+    EndGame board;
+    EndGameInfo info;
+    if (!parse(name, binary, board, info)) {
+        forget(name);
+        return false;
+    }
+    if (scanned) index[name] = info;
+    
+    out = board;
+    remember(name, board, info);
+    return true;
+}
+
+bool EndGameLibrary::parse(const std::string& name, bool binary, EndGame& board, EndGameInfo& info) {
+    std::string path = directory + "/" + name + (binary ? ".endb" : ".end");
+    int64_t mtime, size;
+    if (!statFile(path, mtime, size)) return false;
+    if (!(binary ? board.loadBinary(path) : board.loadText(path))) return false;
+    board.filename = name;
+    
+    info.name = name;
+    info.binary = binary;
+    info.width = board.width;
+    info.height = board.height;
+    info.initialLevel = board.initialLevel;
+    info.mtime = mtime;
+    info.size = size;
+    countBricks(board.bricks, info);
+    return true;
+}
+
+void EndGameLibrary::loadIndex() {
+    std::ifstream file(directory + "/" + INDEX_FILE);
+    std::string line;
+    if (!std::getline(file, line) || line != INDEX_HEADER) return;
+    
+    // The name goes last and runs to the end of the line, so it may hold
+    // spaces
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        EndGameInfo info;
+        int binary;
+        if (fields >> binary >> info.width >> info.height >> info.initialLevel >> info.bricks
+                   >> info.breakable >> info.mtime >> info.size &&
+            fields.get() == ' ' && std::getline(fields, info.name) && !info.name.empty()) {
+            info.binary = (binary != 0);
+            index[info.name] = info;
+        }
+    }
+}
+
+void EndGameLibrary::saveIndex() const {
+    std::ostringstream text;
+    text << INDEX_HEADER << "\n";
+    for (std::map<std::string, EndGameInfo>::const_iterator it = index.begin(); it != index.end(); ++it) {
+        const EndGameInfo& info = it->second;
+        text << (info.binary ? 1 : 0) << " " << info.width << " " << info.height << " " << info.initialLevel
+             << " " << info.bricks << " " << info.breakable << " " << info.mtime << " " << info.size
+             << " " << info.name << "\n";
+    }
+    Utils::writeFileAtomic(directory + "/" + INDEX_FILE, text.str());
+}
+
+void EndGameLibrary::remember(const std::string& name, const EndGame& board, const EndGameInfo& info) {
+    std::map<std::string, Cached>::iterator it = cache.find(name);
+    if (it == cache.end()) {
+        if (cache.size() >= capacity) {
+            cache.erase(recent.back());
+            recent.pop_back();
+        }
+        recent.push_front(name);
+        it = cache.insert(std::make_pair(name, Cached())).first;
+        it->second.recent = recent.begin();
+    } else {
+        recent.splice(recent.begin(), recent, it->second.recent);
+    }
+    it->second.board = board;
+    it->second.binary = info.binary;
+    it->second.mtime = info.mtime;
+    it->second.size = info.size;
+}
+
+void EndGameLibrary::forget(const std::string& name) {
+    std::map<std::string, Cached>::iterator it = cache.find(name);
+    if (it == cache.end()) return;
+    recent.erase(it->second.recent);
+    cache.erase(it);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef ENDGAMELIBRARY_H
+#define ENDGAMELIBRARY_H
+
+#include "EndGame.h"
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// What the menu needs to know about one endgame without loading it
+struct EndGameInfo {
+    std::string name;
+    bool binary;            // .endb rather than .end, see EndGame::resolve()
+    int width, height;
+    int initialLevel;
+    int bricks;             // non-empty cells
+    int breakable;          // bricks that count towards clearing the board
+    int64_t mtime;          // nanoseconds since the epoch
+    int64_t size;           // bytes
+};
+
+// Index of everything in the endgames directory plus a small LRU cache of
+// parsed boards. The index is kept in <directory>/.index, so a later run
+// only re-reads files whose size or mtime changed since it was written.
+class EndGameLibrary {
+private:
+    struct Cached {
+        EndGame board;
+        bool binary;
+        int64_t mtime, size;
+        std::list<std::string>::iterator recent;
+    };
+    
+    std::string directory;
+    size_t capacity;
+    bool scanned;
+    std::map<std::string, EndGameInfo> index;   // by name, so listings come out sorted
+    std::map<std::string, Cached> cache;
+    std::list<std::string> recent;              // most recently loaded first
+    
+public:
+    explicit EndGameLibrary(const std::string& directory = "endgames", size_t capacity = 8);
+    
+    // Rescans the directory; stats every file but only parses changed ones
+    void refresh();
+    // The index as of the last refresh(); the first call scans the directory
+    std::vector<EndGameInfo> list();
+    // Copies the named board into out, from the cache when the file hasn't
+    // changed since it was parsed
+    bool load(const std::string& name, EndGame& out);
+    
+    size_t cached() const { return cache.size(); }
+    
+private:
+    bool parse(const std::string& name, bool binary, EndGame& board, EndGameInfo& info);
+    void loadIndex();
+    void saveIndex() const;
+    void remember(const std::string& name, const EndGame& board, const EndGameInfo& info);
+    void forget(const std::string& name);
+};
+
+#endif
\ No newline at end of file
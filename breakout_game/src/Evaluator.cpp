@@ -0,0 +1,206 @@
+#include "Evaluator.h"
+#include "Simulation.h"
+#include "Bot.h"
+#include "Config.h"
+#include "EndGame.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct GameResult {
+    bool cleared;
+    long ticks;
+    int score;
+    int livesLost;
+};
+
+struct Summary {
+    int games;
+    int cleared;
+    double meanTicksToClear;
+    double meanScore;
+    int minScore, p10Score, p50Score, p90Score, maxScore;
+    double meanLivesLost;
+};
+
+// Everything a worker needs to set up one game; shared read-only
+struct Layout {
+    int width, height;
+    int level;
+    bool hasEndGame;
+    EndGame endgame;
+    double ballStep;
+    double powerUpChance;
+    bool fixedPoint;
+};
+
+GameResult playGame(const Layout& layout, uint64_t seed, long maxTicks) {
+    Simulation sim(layout.width, layout.height);
+    sim.setFixedPoint(layout.fixedPoint);
+    sim.setBallStep(layout.ballStep);
+    sim.setPowerUps(layout.powerUpChance, Simulation::MAX_BALLS);
+    sim.seed(seed);
+    sim.reset(layout.level);
+    if (layout.hasEndGame) {
+        sim.loadEndGame(layout.endgame);
+    }
+    // The bot gets its own stream so its choices don't shift the game's
+    Bot bot(seed ^ 0x5DEECE66DULL);
+    
+    GameResult result;
+    result.cleared = false;
+    StepEvent event = StepEvent::NONE;
+    while (sim.getTick() < maxTicks) {
+        event = sim.step(bot.decide(sim));
+        if (event != StepEvent::NONE) break;
+    }
+    result.cleared = (event == StepEvent::LEVEL_COMPLETE || event == StepEvent::GAME_WON);
+    result.ticks = sim.getTick();
+    result.score = sim.getScore();
+    result.livesLost = (event == StepEvent::GAME_OVER) ? 3 : 3 - sim.getLives();
+    return result;
+}
+
+int percentile(const std::vector<int>& sorted, int p) {
+    size_t index = (sorted.size() - 1) * p / 100;
+    return sorted[index];
+}
+
+Summary summarize(const std::vector<GameResult>& results) {
+    Summary s;
+    s.games = static_cast<int>(results.size());
+    s.cleared = 0;
+    double clearTicks = 0, scoreSum = 0, livesSum = 0;
+    std::vector<int> scores;
+    scores.reserve(results.size());
+    
+    for (const auto& r : results) {
+        if (r.cleared) {
+            s.cleared++;
+            clearTicks += r.ticks;
+        }
+        scoreSum += r.score;
+        livesSum += r.livesLost;
+        scores.push_back(r.score);
+    }
+    std::sort(scores.begin(), scores.end());
+    
+    s.meanTicksToClear = s.cleared ? clearTicks / s.cleared : 0;
+    s.meanScore = scoreSum / s.games;
+    s.meanLivesLost = livesSum / s.games;
+    s.minScore = scores.front();
+    s.p10Score = percentile(scores, 10);
+    s.p50Score = percentile(scores, 50);
+    s.p90Score = percentile(scores, 90);
+    s.maxScore = scores.back();
+    return s;
+}
+
+std::string toJson(const EvalOptions& opts, const Summary& s, int threads, double seconds) {
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"layout\": \"" << (opts.endgame.empty() ? "level " + std::to_string(opts.level) : opts.endgame) << "\",\n"
+         << "  \"games\": " << s.games << ",\n"
+         << "  \"seed\": " << opts.seed << ",\n"
+         << "  \"threads\": " << threads << ",\n"
+         << "  \"seconds\": " << seconds << ",\n"
+         << "  \"clear_rate\": " << static_cast<double>(s.cleared) / s.games << ",\n"
+         << "  \"mean_ticks_to_clear\": " << s.meanTicksToClear << ",\n"
+         << "  \"mean_lives_lost\": " << s.meanLivesLost << ",\n"
+         << "  \"score\": { \"mean\": " << s.meanScore << ", \"min\": " << s.minScore
+         << ", \"p10\": " << s.p10Score << ", \"p50\": " << s.p50Score
+         << ", \"p90\": " << s.p90Score << ", \"max\": " << s.maxScore << " }\n"
+         << "}\n";
+    return json.str();
+}
+
+}
+
+EvalOptions::EvalOptions()
+    : level(1), games(1000), threads(0), seed(1), maxTicks(200000) {}
+
+int runEvaluation(const EvalOptions& opts) {
+    Config config;
+    if (!opts.config.empty() && !config.loadFromFile(opts.config)) {
+        std::cerr << "Failed to load config: " << opts.config << std::endl;
+        return 1;
+    }
+    
+    Layout layout;
+    layout.width = Simulation::DEFAULT_WIDTH;
+    layout.height = Simulation::DEFAULT_HEIGHT;
+    layout.level = opts.level;
+    layout.hasEndGame = !opts.endgame.empty();
+    layout.ballStep = static_cast<double>(config.ballSpeed) / config.tickRate;
+    layout.powerUpChance = config.multiBall / 100.0;
+    layout.fixedPoint = config.fixedPoint;
+    if (layout.hasEndGame) {
+        if (!layout.endgame.loadFromFile(opts.endgame)) {
+            std::cerr << "Failed to load end game: " << opts.endgame << std::endl;
+            return 1;
+        }
+        layout.width = layout.endgame.width;
+        layout.height = layout.endgame.height;
+    }
+    if (opts.games <= 0) {
+        std::cerr << "Nothing to evaluate" << std::endl;
+        return 1;
+    }
+    
+    int threads = opts.threads;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    if (threads > opts.games) threads = opts.games;
+    
+    // Game i always uses seed + i, so results don't depend on which thread
+    // picks it up; each slot is written by exactly one worker
+    std::vector<GameResult> results(opts.games);
+    std::atomic<int> nextGame(0);
+    auto worker = [&]() {
+        for (;;) {
+            int i = nextGame.fetch_add(1);
+            if (i >= opts.games) return;
+            results[i] = playGame(layout, opts.seed + i, opts.maxTicks);
+        }
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : pool) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    Summary s = summarize(results);
+    std::cout << "Games:               " << s.games << " on " << threads << " threads in "
+              << seconds << " s" << std::endl;
+    std::cout << "Clear rate:          " << 100.0 * s.cleared / s.games << "%" << std::endl;
+    std::cout << "Mean ticks to clear: " << s.meanTicksToClear << std::endl;
+    std::cout << "Score:               mean " << s.meanScore << ", min " << s.minScore
+              << ", p10 " << s.p10Score << ", p50 " << s.p50Score << ", p90 " << s.p90Score
+              << ", max " << s.maxScore << std::endl;
+    std::cout << "Mean lives lost:     " << s.meanLivesLost << std::endl;
+    
+    if (!opts.output.empty()) {
+        std::ofstream file(opts.output);
+        if (!file.is_open()) {
+            std::cerr << "Failed to write " << opts.output << std::endl;
+            return 1;
+        }
+        file << toJson(opts, s, threads, seconds);
+    }
+    return 0;
+}
\ No newline at end of file
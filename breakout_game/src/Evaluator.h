@@ -0,0 +1,24 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <cstdint>
+#include <string>
+
+struct EvalOptions {
+    std::string endgame;    // endgame name, empty for a built-in level
+    int level;
+    int games;
+    int threads;            // 0 = one per core
+    uint64_t seed;
+    long maxTicks;          // per game
+    std::string config;     // ball speed / tick rate source, empty for defaults
+    std::string output;     // JSON summary path, empty for none
+    
+    EvalOptions();
+};
+
+// Plays opts.games bot games of one layout across a thread pool and
+// reports how hard it is. Returns a process exit code.
+int runEvaluation(const EvalOptions& opts);
+
+#endif
\ No newline at end of file
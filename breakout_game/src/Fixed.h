@@ -0,0 +1,30 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cmath>
+#include <cstdint>
+
+// 16.16 fixed point for the deterministic physics mode. Values live in Ball
+// as doubles, which hold every 16.16 number exactly, and are converted
+// losslessly on the way in and out; everything in between is integer
+// arithmetic, so results don't depend on the compiler, flags or CPU.
+// Products and quotients truncate toward zero.
+class Fixed {
+public:
+    static const int SHIFT = 16;
+    static const int64_t ONE = int64_t(1) << SHIFT;
+    
+    // Exact for any value on the 16.16 grid
+    static int64_t fromDouble(double v) { return static_cast<int64_t>(v * ONE); }
+    static double toDouble(int64_t v) { return static_cast<double>(v) * (1.0 / ONE); }
+    // Nearest grid value, for settings that come from outside
+    static double quantize(double v) { return toDouble(static_cast<int64_t>(std::floor(v * ONE + 0.5))); }
+    
+    static int64_t mul(int64_t a, int64_t b) { return a * b / ONE; }
+    // Grid cell holding pos
+    static int floorCell(int64_t pos) {
+        return static_cast<int>(pos >= 0 ? pos / ONE : -((-pos + ONE - 1) / ONE));
+    }
+};
+
+#endif
\ No newline at end of file
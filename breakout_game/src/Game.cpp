@@ -2,483 +2,586 @@
 #include "Utils.h"
 #include "Brick.h"
 #include <iostream>
+#include <sstream>
 #include <iomanip>
+#include <memory>
+#include <cctype>
 #include <cstdlib>
 #include <ctime>
-#include <termios.h>
+#include <thread>
 #include <unistd.h>
-#include <fcntl.h>
 
-Game::Game() : width(9), height(18), paddleWidth(3), score(0), lives(3), level(1), 
-               gameRunning(false), paused(false) {
-    paddleX = width / 2;
-    srand(time(nullptr));
+namespace {
+
+// How often the menus look for keys and finished saves
+const std::chrono::milliseconds MENU_POLL(20);
+const std::chrono::milliseconds MAX_CATCH_UP(250);
+const std::chrono::milliseconds OVERLAY_INTERVAL(500);
+const std::chrono::seconds SAVE_STATUS_TIME(3);
+
+const char ESCAPE = 27;
+const char BACKSPACE = 127;
+
+}
+
+Game::Game()
+    : sim(Simulation::DEFAULT_WIDTH, Simulation::DEFAULT_HEIGHT), renderer(STDOUT_FILENO),
+      gameRunning(false), screen(Screen::MENU), screenDirty(true), afterMessage(Screen::MENU),
+      pilot(static_cast<uint64_t>(time(nullptr))), autopilot(false),
+      tick(Clock::duration::zero()), frame(Clock::duration::zero()),
+      accumulator(Clock::duration::zero()), endgameLoaded(false) {}
+
+void Game::enableProfiler(const std::string& dumpPath) {
+    profiler.enable(true);
+    profilePath = dumpPath;
 }
 
+// The terminal stays in raw mode for the whole session; every screen reads
+// its keys from the same queue
 void Game::run() {
     initializeGame();
-    mainMenu();
+    input.start();
+    show(Screen::MENU);
+    while (screen != Screen::QUIT) {
+        if (gameRunning) {
+            gameFrame();
+        } else {
+            menuFrame();
+        }
+    }
+    input.stop();
 }
 
 void Game::initializeGame() {
     config.loadDefault();
-    endgame.loadEmpty(width, height);
+    endgame.loadEmpty(sim.getWidth(), sim.getHeight());
+    endgameLoaded = false;
+    // Fails if another game is already publishing; this one then runs unwatched
+    spectators.open();
 }
 
-void Game::mainMenu() {
-    while (true) {
-        Utils::clearScreen();
-        std::cout << "=== BREAKOUT GAME ===" << std::endl;
-        std::cout << "g - Start Game" << std::endl;
-        std::cout << "n - Create End Game" << std::endl;
-        std::cout << "m - Load End Game" << std::endl;
-        std::cout << "i - Create Config" << std::endl;
-        std::cout << "u - Load Config" << std::endl;
-        std::cout << "q - Quit" << std::endl;
-        std::cout << "=====================" << std::endl;
-        
-        char choice;
-        std::cin >> choice;
-        
-        switch (choice) {
-            case 'g':
-                startGame();
-                break;
-            case 'n':
-                createEndGame();
-                break;
-            case 'm':
-                loadEndGame();
-                break;
-            case 'i':
-                createConfig();
-                break;
-            case 'u':
-                loadConfig();
-                break;
-            case 'q':
-                return;
-            default:
-                std::cout << "Invalid choice!" << std::endl;
-                Utils::waitForKey();
-        }
-    }
+void Game::show(Screen next) {
+    screen = next;
+    screenDirty = true;
+}
+
+void Game::showMessage(const std::string& text, Screen next) {
+    message = text;
+    afterMessage = next;
+    messageShown = Clock::now();
+    show(Screen::MESSAGE);
+}
+
+void Game::openForm(const std::string& header, const std::vector<std::string>& questions,
+                    const std::function<void(const std::vector<std::string>&)>& submit) {
+    form.header = header;
+    form.questions = questions;
+    form.answers.clear();
+    form.line.clear();
+    form.submit = submit;
+    show(Screen::FORM);
 }
 
 void Game::startGame() {
     gameRunning = true;
-    paused = false;
-    score = 0;
-    lives = 3;
-    level = config.initialLevel;
-    
-    // Initialize ball
-    ball.x = width / 2.0;
-    ball.y = height - 2;
-    ball.dx = 0;
-    ball.dy = 0;
-    ball.attached = true;
-    
-    // Initialize paddle
-    paddleX = width / 2 - paddleWidth / 2;
     
-    // Load level
-    loadLevel();
-    
-    gameLoop();
+    // A negative seed picks a fresh one; it is kept in the replay either way
+    uint64_t seed = (config.randomSeed >= 0)
+        ? static_cast<uint64_t>(config.randomSeed)
+        : static_cast<uint64_t>(time(nullptr)) ^
+          static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    sim.setFixedPoint(config.fixedPoint);
+    sim.setBallStep(static_cast<double>(config.ballSpeed) / config.tickRate);
+    sim.setPowerUps(config.multiBall / 100.0, Simulation::MAX_BALLS);
+    sim.seed(seed);
+    sim.reset(config.initialLevel);
+    if (endgameLoaded) {
+        sim.loadEndGame(endgame);
+    }
+    replay.begin(sim, seed, config.tickRate, config.initialLevel, endgameLoaded ? &endgame : nullptr);
+    updateOverlay();
+    spectators.invalidate();
+    spectators.publish(sim, false);
+    
+    // Physics runs at a fixed rate; rendering is capped separately and
+    // simply skips frames when it can't keep up
+    tick = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / config.tickRate));
+    frame = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / config.maxFps));
+    accumulator = Clock::duration::zero();
+    previous = Clock::now();
+    nextFrame = previous;
+    nextOverlay = previous;
+    pending = Input();
+    show(Screen::PLAYING);
 }
 
-void Game::gameLoop() {
-    lastUpdate = std::chrono::steady_clock::now();
+// Wraps up the game that just finished and goes back to the menu
+void Game::endGame() {
+    gameRunning = false;
+    spectators.idle();
     
-    while (gameRunning) {
-        if (!paused) {
-            processInput();
-            updateGame();
-            drawGame();
-            
-            // Control game speed based on ball speed
-            double speed = config.ballSpeed;
-            int delay = static_cast<int>(1000.0 / speed);
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
-        } else {
-            processInput();
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
+    if (profiler.isEnabled() && !profiler.dump(profilePath)) {
+        std::cerr << "Failed to write profile: " << profilePath << std::endl;
     }
+    
+    // The writer thread takes the finished recording over; the next game
+    // starts a fresh one
+    replay.finish(sim);
+    std::shared_ptr<Replay> finished = std::make_shared<Replay>(std::move(replay));
+    writer.submit("replay", [finished]() {
+        Utils::createDirectory("replays");
+        return finished->saveToFile("replays/last.rep");
+    });
+    show(Screen::MENU);
 }
 
-void Game::processInput() {
-    if (!Utils::kbhit()) return;
+// One pass of the loop while a game is in progress. The clock only runs
+// while playing; the other screens show over the frozen board.
+void Game::gameFrame() {
+    {
+        ScopedTimer timer(profiler, Phase::INPUT);
+        processInput();
+    }
+    if (!gameRunning) return;
+    pollSaves();
+    
+    Clock::time_point now = Clock::now();
+    if (screen != Screen::PLAYING) {
+        spectators.publish(sim, true);
+        pending = Input();
+        accumulator = Clock::duration::zero();
+        previous = now;
+        if (screenDirty) drawScreen();
+        std::this_thread::sleep_until(now + frame);
+        return;
+    }
     
-    char ch = std::cin.get();
+    accumulator += now - previous;
+    previous = now;
+    if (accumulator > MAX_CATCH_UP) accumulator = MAX_CATCH_UP;
+    
+    while (accumulator >= tick && screen == Screen::PLAYING) {
+        StepEvent event;
+        {
+            ScopedTimer timer(profiler, Phase::SIMULATE);
+            // Restarts still come from the keys with the autopilot on
+            Input control = autopilot ? pilot.decide(sim) : pending;
+            control.restart = control.restart || pending.restart;
+            replay.record(sim, control);
+            event = sim.step(control);
+            pending = Input();
+            accumulator -= tick;
+            renderer.track(sim);
+            spectators.publish(sim, false);
+        }
+        if (event != StepEvent::NONE) {
+            handleEvent(event);
+        }
+    }
     
-    if (paused) {
-        switch (ch) {
-            case 'p':
-                paused = false;
-                break;
-            case 's':
-                saveEndGameFromPause();
-                break;
-            case 'r':
-                return;
+    now = Clock::now();
+    if (profiler.isEnabled() && now >= nextOverlay) {
+        profiler.updateOverlay();
+        updateOverlay();
+        nextOverlay = now + OVERLAY_INTERVAL;
+    }
+    if (now >= nextFrame || screenDirty) {
+        ScopedTimer timer(profiler, Phase::RENDER);
+        drawScreen();
+        nextFrame += frame;
+        if (nextFrame <= now) {
+            // Rendering fell behind: drop the missed frames
+            nextFrame = now + frame;
         }
-        return;
     }
     
-    switch (ch) {
-        case 'a':
-            if (paddleX > 0) paddleX--;
+    Clock::time_point nextTick = now + (tick - accumulator);
+    ScopedTimer timer(profiler, Phase::SLEEP);
+    std::this_thread::sleep_until(nextTick < nextFrame ? nextTick : nextFrame);
+}
+
+// The menus only need to notice keys and finished saves
+void Game::menuFrame() {
+    processInput();
+    if (gameRunning || screen == Screen::QUIT) return;
+    pollSaves();
+    drawScreen();
+    std::this_thread::sleep_for(MENU_POLL);
+}
+
+// Shows the current screen. In a game it goes below the board, which the
+// renderer repaints in full whenever that text changes; elsewhere the
+// screen is cleared and the text printed on its own.
+void Game::drawScreen() {
+    if (gameRunning) {
+        if (screenDirty) renderer.invalidate();
+        renderer.render(sim, screen == Screen::PAUSED || screen == Screen::FORM);
+    } else if (screenDirty) {
+        Utils::clearScreen();
+    }
+    if (screenDirty) {
+        std::cout << screenText() << std::flush;
+        screenDirty = false;
+    }
+}
+
+std::string Game::screenText() const {
+    std::string text;
+    switch (screen) {
+        case Screen::MENU:
+            if (!saveStatus.empty()) text += saveStatus + "\n";
+            text += "=== BREAKOUT GAME ===\n";
+            text += "g - Start Game\n";
+            text += "n - Create End Game\n";
+            text += "m - Load End Game\n";
+            text += "i - Create Config\n";
+            text += "u - Load Config\n";
+            text += "q - Quit\n";
+            text += "=====================\n";
             break;
-        case 'd':
-            if (paddleX < width - paddleWidth) paddleX++;
+        case Screen::PAUSED:
+            text += "PAUSE MENU\n";
+            text += "p - Continue\n";
+            text += "s - Save End Game\n";
+            text += "r - Restart Level\n";
             break;
-        case ' ':
-            if (ball.attached) {
-                ball.attached = false;
-                ball.dx = (rand() % 3 - 1) * 0.5; // -0.5, 0, or 0.5
-                ball.dy = -1.0;
+        case Screen::FORM:
+            text += form.header;
+            for (size_t i = 0; i < form.answers.size(); i++) {
+                text += form.questions[i] + form.answers[i] + "\n";
             }
+            text += form.questions[form.answers.size()] + form.line;
             break;
-        case 'p':
-            paused = true;
-            showPauseMenu();
+        case Screen::MESSAGE:
+            text += message + "\nPress any key to continue...";
             break;
-        case 'r':
-            loadLevel();
+        case Screen::PLAYING:
+        case Screen::QUIT:
             break;
     }
+    return text;
 }
 
-void Game::updateGame() {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate);
-    
-    if (elapsed.count() < 50) return; // Update every 50ms
-    
-    lastUpdate = now;
-    
-    if (ball.attached) {
-        ball.x = paddleX + paddleWidth / 2.0;
-        return;
+// Drains everything typed since the last pass. Each key goes to the screen
+// showing when it is handled, so a key that changes screen hands the rest
+// to the new one.
+void Game::processInput() {
+    KeyEvent event;
+    while (screen != Screen::QUIT && input.poll(event)) {
+        handleKey(event);
     }
-    
-    // Move ball
-    ball.x += ball.dx;
-    ball.y += ball.dy;
-    
-    handleCollisions();
-    
-    // Check if level complete
-    bool levelComplete = true;
-    for (const auto& row : bricks) {
-        for (const auto& brick : row) {
-            if (brick.type != BrickType::EMPTY && brick.type != BrickType::INDESTRUCTIBLE) {
-                levelComplete = false;
-                break;
+}
+
+void Game::handleKey(const KeyEvent& event) {
+    switch (screen) {
+        case Screen::MENU:
+            menuKey(event.key);
+            break;
+        case Screen::PLAYING:
+            playKey(event.key);
+            break;
+        case Screen::PAUSED:
+            pauseKey(event.key);
+            break;
+        case Screen::FORM:
+            formKey(event.key);
+            break;
+        case Screen::MESSAGE:
+            // Keys already typed when the message went up, e.g. during play,
+            // don't dismiss it
+            if (event.time < messageShown) break;
+            if (gameRunning && afterMessage == Screen::MENU) {
+                endGame();
+            } else {
+                show(afterMessage);
             }
-        }
-        if (!levelComplete) break;
-    }
-    
-    if (levelComplete) {
-        nextLevel();
+            break;
+        case Screen::QUIT:
+            break;
     }
 }
 
-void Game::handleCollisions() {
-    // Wall collisions
-    if (ball.x <= 0 || ball.x >= width - 1) {
-        ball.dx = -ball.dx;
-        ball.x = (ball.x <= 0) ? 0 : width - 1;
-    }
-    
-    if (ball.y <= 0) {
-        ball.dy = -ball.dy;
-        ball.y = 0;
-    }
-    
-    // Bottom collision (lose life)
-    if (ball.y >= height) {
-        lives--;
-        if (lives <= 0) {
-            gameOver();
-            return;
-        }
-        ball.attached = true;
-        ball.x = paddleX + paddleWidth / 2.0;
-        ball.y = height - 2;
-        return;
+void Game::menuKey(char ch) {
+    switch (ch) {
+        case 'g':
+            startGame();
+            break;
+        case 'n':
+            createEndGame();
+            break;
+        case 'm':
+            loadEndGame();
+            break;
+        case 'i':
+            createConfig();
+            break;
+        case 'u':
+            loadConfig();
+            break;
+        case 'q':
+            show(Screen::QUIT);
+            break;
+        default:
+            if (!std::isspace(static_cast<unsigned char>(ch))) {
+                showMessage("Invalid choice!", Screen::MENU);
+            }
     }
-    
-    // Paddle collision
-    if (ball.y >= height - 2 && ball.dy > 0) {
-        if (ball.x >= paddleX && ball.x <= paddleX + paddleWidth) {
-            double hitPos = (ball.x - paddleX) / paddleWidth;
-            double dx = (hitPos - 0.5) * 2.0; // -1 to 1
-            ball.dx = dx * 1.5;
-            ball.dy = -abs(ball.dy);
-            ball.y = height - 2;
-        }
+}
+
+void Game::playKey(char ch) {
+    switch (ch) {
+        case 'a':
+            pending.move--;
+            break;
+        case 'd':
+            pending.move++;
+            break;
+        case ' ':
+            pending.launch = true;
+            break;
+        case 'p':
+            show(Screen::PAUSED);
+            break;
+        case 'r':
+            pending.restart = true;
+            break;
+        case 'o':
+            autopilot = !autopilot;
+            updateOverlay();
+            break;
     }
-    
-    // Brick collisions
-    for (auto& row : bricks) {
-        for (auto& brick : row) {
-            if (brick.type == BrickType::EMPTY) continue;
-            
-            if (ball.x >= brick.x && ball.x <= brick.x + 1 &&
-                ball.y >= brick.y && ball.y <= brick.y + 1) {
-                
-                // Handle different brick types
-                if (brick.type == BrickType::NORMAL) {
-                    brick.type = BrickType::EMPTY;
-                    score += 10;
-                } else if (brick.type == BrickType::DURABLE) {
-                    brick.durability--;
-                    if (brick.durability <= 0) {
-                        brick.type = BrickType::EMPTY;
-                    }
-                    score += 5;
-                }
-                // INDESTRUCTIBLE bricks don't break
-                
-                // Bounce ball
-                double brickCenterX = brick.x + 0.5;
-                double brickCenterY = brick.y + 0.5;
-                double dx = ball.x - brickCenterX;
-                double dy = ball.y - brickCenterY;
-                
-                if (abs(dx) > abs(dy)) {
-                    ball.dx = -ball.dx;
-                } else {
-                    ball.dy = -ball.dy;
-                }
-                
-                return; // Only handle one collision per frame
-            }
-        }
+}
+
+void Game::pauseKey(char ch) {
+    switch (ch) {
+        case 'p':
+            show(Screen::PLAYING);
+            break;
+        case 's':
+            saveEndGameFromPause();
+            break;
     }
 }
 
-void Game::drawGame() {
-    Utils::clearScreen();
-    
-    // Draw score and status
-    std::cout << "Score: " << score << " | Lives: " << lives << " | Level: " << level << std::endl;
-    std::cout << std::string(width * 2 + 2, '-') << std::endl;
-    
-    // Draw game area
-    for (int y = 0; y < height; y++) {
-        std::cout << "|";
-        for (int x = 0; x < width; x++) {
-            // Check for ball
-            if (!ball.attached && static_cast<int>(ball.x) == x && static_cast<int>(ball.y) == y) {
-                std::cout << "()";
-                continue;
-            }
-            
-            // Check for bricks
-            bool brickFound = false;
-            for (const auto& row : bricks) {
-                for (const auto& brick : row) {
-                    if (brick.x == x && brick.y == y && brick.type != BrickType::EMPTY) {
-                        std::cout << static_cast<char>(brick.type) << static_cast<char>(brick.type);
-                        brickFound = true;
-                        break;
-                    }
-                }
-                if (brickFound) break;
-            }
-            if (brickFound) continue;
-            
-            // Check for paddle
-            if (y == height - 1 && x >= paddleX && x < paddleX + paddleWidth) {
-                std::cout << "--";
-                continue;
-            }
-            
-            // Empty space
-            std::cout << "  ";
+// Answers are single words, as they were read with std::cin >>
+void Game::formKey(char ch) {
+    Screen back = gameRunning ? Screen::PAUSED : Screen::MENU;
+    screenDirty = true;
+    if (ch == ESCAPE) {
+        show(back);
+    } else if (ch == '\n' || ch == '\r') {
+        if (form.line.empty()) return;
+        if (form.answers.empty() && form.line == "q") {
+            show(back);
+            return;
         }
-        std::cout << "|" << std::endl;
-    }
-    
-    std::cout << std::string(width * 2 + 2, '-') << std::endl;
-    
-    if (paused) {
-        std::cout << "PAUSED - Press 'p' to continue, 's' to save, 'r' to restart" << std::endl;
-    } else {
-        std::cout << "Controls: a-left, d-right, space-launch, p-pause, r-restart" << std::endl;
+        form.answers.push_back(form.line);
+        form.line.clear();
+        if (form.answers.size() == form.questions.size()) {
+            // submit may put up a message in place of the previous screen, or
+            // open another form, so it runs from its own copy
+            std::function<void(const std::vector<std::string>&)> submit;
+            std::vector<std::string> answers;
+            submit.swap(form.submit);
+            answers.swap(form.answers);
+            show(back);
+            submit(answers);
+        }
+    } else if (ch == BACKSPACE || ch == '\b') {
+        if (!form.line.empty()) form.line.erase(form.line.size() - 1);
+    } else if (std::isgraph(static_cast<unsigned char>(ch))) {
+        form.line += ch;
     }
 }
 
-void Game::loadLevel() {
-    bricks.clear();
-    
-    // Create some sample bricks for the level
-    for (int y = 0; y < 4; y++) {
-        std::vector<Brick> row;
-        for (int x = 0; x < width; x++) {
-            BrickType type;
-            if (y == 0 && x % 3 == 0) {
-                type = BrickType::INDESTRUCTIBLE;
-            } else if (y == 1 && x % 2 == 0) {
-                type = BrickType::DURABLE;
+void Game::handleEvent(StepEvent event) {
+    std::ostringstream text;
+    switch (event) {
+        case StepEvent::LEVEL_COMPLETE:
+        case StepEvent::GAME_WON:
+            if (sim.getLevel() > LEVEL_COUNT) {
+                showMessage("Congratulations! You beat all levels!", Screen::MENU);
             } else {
-                type = BrickType::NORMAL;
+                text << "Level " << sim.getLevel() << " complete! Loading next level...";
+                showMessage(text.str(), Screen::PLAYING);
             }
-            row.emplace_back(x, y, type);
-        }
-        bricks.push_back(row);
+            break;
+        case StepEvent::GAME_OVER:
+            text << "GAME OVER! Final Score: " << sim.getScore();
+            showMessage(text.str(), Screen::MENU);
+            break;
+        case StepEvent::NONE:
+            break;
     }
-    
-    // Reset ball position
-    ball.attached = true;
-    ball.x = paddleX + paddleWidth / 2.0;
-    ball.y = height - 2;
 }
 
-void Game::nextLevel() {
-    level++;
-    if (level > 3) { // Simple level cap
-        std::cout << "Congratulations! You beat all levels!" << std::endl;
-        Utils::waitForKey();
-        gameRunning = false;
+// Takes the latest save result, if any, onto the status line for a while
+void Game::pollSaves() {
+    std::string result;
+    bool any = false;
+    while (writer.poll(result)) {
+        saveStatus = result;
+        any = true;
+    }
+    if (any) {
+        saveStatusUntil = Clock::now() + SAVE_STATUS_TIME;
+    } else if (!saveStatus.empty() && Clock::now() >= saveStatusUntil) {
+        saveStatus.clear();
+    } else {
         return;
     }
-    
-    std::cout << "Level " << level << " complete! Loading next level..." << std::endl;
-    Utils::waitForKey();
-    loadLevel();
-}
-
-void Game::gameOver() {
-    drawGame();
-    std::cout << "GAME OVER! Final Score: " << score << std::endl;
-    Utils::waitForKey();
-    gameRunning = false;
+    updateOverlay();
+    if (screen != Screen::PLAYING) screenDirty = true;
 }
 
-void Game::showPauseMenu() {
-    drawGame();
-    std::cout << "PAUSE MENU" << std::endl;
-    std::cout << "p - Continue" << std::endl;
-    std::cout << "s - Save End Game" << std::endl;
-    std::cout << "r - Restart Level" << std::endl;
+void Game::updateOverlay() {
+    std::string text = profiler.isEnabled() ? profiler.getOverlay() : std::string();
+    if (autopilot) {
+        text += (text.empty() ? "" : " | ") + std::string("Autopilot");
+    }
+    if (!saveStatus.empty()) {
+        text += (text.empty() ? "" : " | ") + saveStatus;
+    }
+    renderer.setOverlay(text);
 }
 
 void Game::createConfig() {
-    std::string filename;
-    std::cout << "Enter config name (q to cancel): ";
-    std::cin >> filename;
-    
-    if (filename == "q") return;
-    
-    Config newConfig;
-    newConfig.filename = filename;
-    
-    std::cout << "Enter ball speed (1-10): ";
-    std::cin >> newConfig.ballSpeed;
-    std::cout << "Enter random seed (-1 for random): ";
-    std::cin >> newConfig.randomSeed;
-    std::cout << "Enter initial level: ";
-    std::cin >> newConfig.initialLevel;
-    
-    newConfig.saveToFile();
-    config = newConfig;
+    openForm("", {
+        "Enter config name (q to cancel): ",
+        "Enter ball speed in cells per second (1-10): ",
+        "Enter random seed (-1 for random): ",
+        "Enter initial level: ",
+        "Enter physics updates per second (e.g. 60): ",
+        "Enter max frames per second (e.g. 30): ",
+        "Enter multi-ball chance per destroyed brick in percent (0-100): ",
+        "Use fixed-point physics, same games on every machine (0/1): "
+    }, [this](const std::vector<std::string>& answers) {
+        Config newConfig;
+        newConfig.filename = answers[0];
+        newConfig.ballSpeed = std::atoi(answers[1].c_str());
+        newConfig.randomSeed = std::atoi(answers[2].c_str());
+        newConfig.initialLevel = std::atoi(answers[3].c_str());
+        newConfig.tickRate = std::atoi(answers[4].c_str());
+        newConfig.maxFps = std::atoi(answers[5].c_str());
+        newConfig.multiBall = std::atoi(answers[6].c_str());
+        newConfig.fixedPoint = std::atoi(answers[7].c_str()) != 0;
+        if (newConfig.tickRate <= 0) newConfig.tickRate = 60;
+        if (newConfig.maxFps <= 0) newConfig.maxFps = 30;
+        if (newConfig.multiBall < 0 || newConfig.multiBall > 100) newConfig.multiBall = 10;
+        
+        writer.submit("config " + newConfig.filename, [newConfig]() { return newConfig.saveToFile(); });
+        config = newConfig;
+    });
 }
 
 void Game::loadConfig() {
-    std::string filename;
-    std::cout << "Current config: " << config.filename << std::endl;
-    std::cout << "Enter config name to load (q to cancel): ";
-    std::cin >> filename;
-    
-    if (filename == "q") return;
-    
-    if (config.loadFromFile(filename)) {
-        std::cout << "Config loaded successfully!" << std::endl;
-    } else {
-        std::cout << "Failed to load config!" << std::endl;
-    }
-    Utils::waitForKey();
+    openForm("Current config: " + config.filename + "\n", {
+        "Enter config name to load (q to cancel): "
+    }, [this](const std::vector<std::string>& answers) {
+        if (config.loadFromFile(answers[0])) {
+            showMessage("Config loaded successfully!", Screen::MENU);
+        } else {
+            showMessage("Failed to load config!", Screen::MENU);
+        }
+    });
 }
 
 void Game::createEndGame() {
-    std::string filename;
-    std::cout << "Enter endgame name (q to cancel): ";
-    std::cin >> filename;
-    
-    if (filename == "q") return;
-    
-    EndGame newEndGame;
-    newEndGame.filename = filename;
-    
-    std::cout << "Enter width (8-20): ";
-    std::cin >> newEndGame.width;
-    std::cout << "Enter height (8-20): ";
-    std::cin >> newEndGame.height;
-    std::cout << "Enter initial level: ";
-    std::cin >> newEndGame.initialLevel;
-    
-    // Simple brick placement - in a full implementation, this would be interactive
-    newEndGame.bricks.emplace_back(2, 2, BrickType::NORMAL);
-    newEndGame.bricks.emplace_back(4, 2, BrickType::DURABLE);
-    newEndGame.bricks.emplace_back(6, 2, BrickType::INDESTRUCTIBLE);
-    
-    newEndGame.saveToFile();
-    endgame = newEndGame;
-    
-    // Update game dimensions
-    width = newEndGame.width;
-    height = newEndGame.height;
-    
-    std::cout << "End game created successfully!" << std::endl;
-    Utils::waitForKey();
+    openForm("", {
+        "Enter endgame name (q to cancel): ",
+        "Enter width (8-" + std::to_string(EndGame::MAX_SIZE) + "): ",
+        "Enter height (8-" + std::to_string(EndGame::MAX_SIZE) + "): ",
+        "Enter initial level: "
+    }, [this](const std::vector<std::string>& answers) {
+        EndGame newEndGame;
+        newEndGame.filename = answers[0];
+        newEndGame.width = std::atoi(answers[1].c_str());
+        newEndGame.height = std::atoi(answers[2].c_str());
+        newEndGame.initialLevel = std::atoi(answers[3].c_str());
+        if (newEndGame.width < 8 || newEndGame.width > EndGame::MAX_SIZE ||
+            newEndGame.height < 8 || newEndGame.height > EndGame::MAX_SIZE) {
+            showMessage("Invalid board size!", Screen::MENU);
+            return;
+        }
+        if (newEndGame.initialLevel < 1) {
+            showMessage("Levels start at 1!", Screen::MENU);
+            return;
+        }
+        
+        // Simple brick placement - in a full implementation, this would be interactive
+        newEndGame.bricks.resize(newEndGame.width, newEndGame.height);
+        if (newEndGame.bricks.inside(6, 2)) {
+            newEndGame.bricks.set(2, 2, BrickType::NORMAL);
+            newEndGame.bricks.set(4, 2, BrickType::DURABLE);
+            newEndGame.bricks.set(6, 2, BrickType::INDESTRUCTIBLE);
+        }
+        
+        endgame = newEndGame;
+        endgameLoaded = true;
+        writer.submit("endgame " + newEndGame.filename, [newEndGame]() { return newEndGame.saveToFile(); });
+        
+        // Update game dimensions
+        sim.resize(newEndGame.width, newEndGame.height);
+        
+        showMessage("End game created!", Screen::MENU);
+    });
 }
 
+// Lists what the library already knows; the directory is scanned the first
+// time and afterwards only when asked for with 'r'
 void Game::loadEndGame() {
-    std::string filename;
-    std::cout << "Current endgame: " << endgame.filename << std::endl;
-    std::cout << "Enter endgame name to load (q to cancel): ";
-    std::cin >> filename;
-    
-    if (filename == "q") return;
-    
-    if (endgame.loadFromFile(filename)) {
-        std::cout << "End game loaded successfully!" << std::endl;
-        width = endgame.width;
-        height = endgame.height;
-        level = endgame.initialLevel;
-    } else {
-        std::cout << "Failed to load end game!" << std::endl;
+    std::vector<EndGameInfo> available = library.list();
+    std::ostringstream header;
+    if (!available.empty()) {
+        header << "Available endgames:\n";
+        for (size_t i = 0; i < available.size(); i++) {
+            const EndGameInfo& info = available[i];
+            header << "  " << std::left << std::setw(20) << info.name << std::right
+                   << " " << info.width << "x" << info.height
+                   << ", level " << info.initialLevel
+                   << ", " << info.bricks << " bricks (" << info.breakable << " breakable)\n";
+        }
     }
-    Utils::waitForKey();
+    header << "Current endgame: " << (endgameLoaded ? endgame.filename : "none") << "\n";
+    
+    openForm(header.str(), {
+        "Enter endgame name to load (r to rescan, q to cancel): "
+    }, [this](const std::vector<std::string>& answers) {
+        if (answers[0] == "r") {
+            library.refresh();
+            loadEndGame();
+            return;
+        }
+        if (library.load(answers[0], endgame)) {
+            endgameLoaded = true;
+            sim.resize(endgame.width, endgame.height);
+            showMessage("End game loaded successfully!", Screen::MENU);
+        } else {
+            // Back to the built-in levels rather than a board the user
+            // just tried to replace
+            endgameLoaded = false;
+            endgame.loadEmpty(Simulation::DEFAULT_WIDTH, Simulation::DEFAULT_HEIGHT);
+            sim.resize(Simulation::DEFAULT_WIDTH, Simulation::DEFAULT_HEIGHT);
+            showMessage("Failed to load end game!", Screen::MENU);
+        }
+    });
 }
 
+// Snapshots the board as it is when 's' is pressed; the writer thread owns
+// the copy from then on and the game never waits for the disk
 void Game::saveEndGameFromPause() {
-    std::string filename;
-    std::cout << "Enter filename to save endgame: ";
-    std::cin >> filename;
-    
-    EndGame newEndGame;
-    newEndGame.filename = filename;
-    newEndGame.width = width;
-    newEndGame.height = height;
-    newEndGame.initialLevel = level;
-    
-    // Copy current bricks
-    for (const auto& row : bricks) {
-        for (const auto& brick : row) {
-            if (brick.type != BrickType::EMPTY) {
-                newEndGame.bricks.push_back(brick);
-            }
-        }
-    }
-    
-    newEndGame.saveToFile();
-    std::cout << "End game saved successfully!" << std::endl;
-    Utils::waitForKey();
+    std::shared_ptr<EndGame> snapshot = std::make_shared<EndGame>();
+    snapshot->width = sim.getWidth();
+    snapshot->height = sim.getHeight();
+    snapshot->initialLevel = sim.getLevel();
+    snapshot->bricks = sim.getBricks();
+    
+    openForm("", {
+        "Enter filename to save endgame (q to cancel): "
+    }, [this, snapshot](const std::vector<std::string>& answers) {
+        snapshot->filename = answers[0];
+        writer.submit("endgame " + snapshot->filename, [snapshot]() { return snapshot->saveToFile(); });
+    });
 }
\ No newline at end of file
@@ -3,59 +3,113 @@
 
 #include "Config.h"
 #include "EndGame.h"
-#include "Brick.h"  // 包含 Brick 定义
-#include <vector>
-#include <string>
+#include "EndGameLibrary.h"
+#include "Simulation.h"
+#include "Renderer.h"
+#include "InputThread.h"
+#include "Replay.h"
+#include "Profiler.h"
+#include "SaveWriter.h"
+#include "Spectator.h"
+#include "Bot.h"
 #include <chrono>
-#include <thread>
-
-// 移除 BrickType 和 Brick 的定义，它们现在在 Brick.h 中
+#include <functional>
+#include <string>
+#include <vector>
 
-struct Ball {
-    double x, y;
-    double dx, dy;
-    bool attached;
-    
-    Ball() : x(0), y(0), dx(0), dy(0), attached(true) {}
+// Everything the player sees is a screen of one state machine, driven by
+// the same key queue and loop: nothing waits on the terminal, so play,
+// spectators and saves keep going whatever is on screen
+enum class Screen {
+    MENU,
+    PLAYING,
+    PAUSED,
+    FORM,       // questions answered one line at a time
+    MESSAGE,    // text shown until the next key press
+    QUIT
 };
 
 class Game {
 private:
+    typedef std::chrono::steady_clock Clock;
+    
+    // A run of questions, e.g. the fields of a new config. Answers go to
+    // submit once the last one is entered; a first answer of "q" or Escape
+    // cancels.
+    struct Form {
+        std::string header;                 // printed above the questions
+        std::vector<std::string> questions;
+        std::vector<std::string> answers;
+        std::string line;                   // answer being typed
+        std::function<void(const std::vector<std::string>&)> submit;
+    };
+    
     // Game state
-    int width, height;
-    int paddleX, paddleWidth;
-    Ball ball;
-    std::vector<std::vector<Brick>> bricks;
-    int score;
-    int lives;
-    int level;
-    bool gameRunning;
-    bool paused;
+    Simulation sim;
+    Renderer renderer;
+    InputThread input;
+    Replay replay;              // the session being played, saved when it ends
+    bool gameRunning;           // a game is in progress, shown or not
+    Screen screen;
+    bool screenDirty;           // screen text must be printed again
+    Form form;
+    std::string message;
+    Screen afterMessage;
+    Clock::time_point messageShown; // keys typed before this don't dismiss it
+    Profiler profiler;
+    std::string profilePath;    // where the timings go when a game ends
+    SaveWriter writer;          // config, endgame and replay files are written here
+    std::string saveStatus;     // last save result, shown on the status line
+    SpectatorFeed spectators;   // what breakout --spectate shows
+    Bot pilot;
+    bool autopilot;             // pilot plays instead of the keys; 'o' toggles
+    
+    // Loop timing, set up by startGame()
+    Clock::duration tick;
+    Clock::duration frame;
+    Clock::duration accumulator;
+    Clock::time_point previous;
+    Clock::time_point nextFrame;
+    Clock::time_point nextOverlay;
+    Clock::time_point saveStatusUntil;
+    Input pending;              // keys since the last tick
     
     // Configuration
     Config config;
     EndGame endgame;
-    
-    // Timing
-    std::chrono::steady_clock::time_point lastUpdate;
+    bool endgameLoaded;         // endgame replaces the built-in layout on its level
+    EndGameLibrary library;     // what's in endgames/, plus recently played boards
     
 public:
     Game();
     void run();
+    // Times every game loop phase, shows p50/p99 on the status line and
+    // writes the histograms to dumpPath after each game
+    void enableProfiler(const std::string& dumpPath);
+    // Starts every game with the paddle played by the bot
+    void enableAutopilot() { autopilot = true; }
     
 private:
     void initializeGame();
-    void mainMenu();
+    void show(Screen next);
+    void showMessage(const std::string& text, Screen next);
+    void openForm(const std::string& header, const std::vector<std::string>& questions,
+                  const std::function<void(const std::vector<std::string>&)>& submit);
     void startGame();
-    void gameLoop();
-    void drawGame();
+    void endGame();
+    void gameFrame();
+    void menuFrame();
+    void drawScreen();
+    std::string screenText() const;
     void processInput();
-    void updateGame();
-    void handleCollisions();
-    void loadLevel();
-    void nextLevel();
-    void gameOver();
-    void showPauseMenu();
+    void handleKey(const KeyEvent& event);
+    void menuKey(char ch);
+    void playKey(char ch);
+    void pauseKey(char ch);
+    void formKey(char ch);
+    void handleEvent(StepEvent event);
+    void pollSaves();
+    void updateOverlay();
     
     // Configuration functions
     void createConfig();
@@ -0,0 +1,132 @@
+#include "InputThread.h"
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <csignal>
+
+namespace {
+
+// Signals that end the process without running destructors; their handlers
+// put the terminal back first. tcsetattr() and sigaction() are both
+// async-signal-safe.
+const int RESTORE_SIGNALS[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
+const int RESTORE_COUNT = sizeof(RESTORE_SIGNALS) / sizeof(RESTORE_SIGNALS[0]);
+
+struct termios signalRestore;
+struct sigaction previous[RESTORE_COUNT];
+
+void onFatalSignal(int sig) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &signalRestore);
+    for (int i = 0; i < RESTORE_COUNT; i++) {
+        if (RESTORE_SIGNALS[i] == sig) sigaction(sig, &previous[i], nullptr);
+    }
+    raise(sig);
+}
+
+}
+
+RawTerminal::RawTerminal() : active(false) {
+    if (tcgetattr(STDIN_FILENO, &saved) != 0) return;
+    
+    // Installed before the mode changes, so there is no window in which a
+    // signal leaves the terminal raw
+    signalRestore = saved;
+    struct sigaction action;
+    action.sa_handler = onFatalSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;
+    for (int i = 0; i < RESTORE_COUNT; i++) {
+        sigaction(RESTORE_SIGNALS[i], &action, &previous[i]);
+    }
+    
+    struct termios raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    active = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+    if (!active) restoreHandlers();
+}
+
+RawTerminal::~RawTerminal() {
+    if (active) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        restoreHandlers();
+    }
+}
+
+void RawTerminal::restoreHandlers() {
+    for (int i = 0; i < RESTORE_COUNT; i++) {
+        sigaction(RESTORE_SIGNALS[i], &previous[i], nullptr);
+    }
+}
+
+InputThread::InputThread() : running(false) {
+    wakePipe[0] = wakePipe[1] = -1;
+}
+
+InputThread::~InputThread() {
+    stop();
+}
+
+void InputThread::start() {
+    if (running.load()) return;
+    
+    if (pipe(wakePipe) != 0) {
+        wakePipe[0] = wakePipe[1] = -1;
+    }
+    raw.reset(new RawTerminal());
+    running.store(true);
+    worker = std::thread(&InputThread::run, this);
+}
+
+void InputThread::stop() {
+    if (!running.load()) return;
+    
+    running.store(false);
+    if (wakePipe[1] >= 0) {
+        char c = 0;
+        ssize_t ignored = write(wakePipe[1], &c, 1);
+        (void)ignored;
+    }
+    worker.join();
+    
+    raw.reset();
+    for (int i = 0; i < 2; i++) {
+        if (wakePipe[i] >= 0) close(wakePipe[i]);
+        wakePipe[i] = -1;
+    }
+}
+
+void InputThread::run() {
+    struct pollfd fds[2];
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakePipe[0];
+    fds[1].events = POLLIN;
+    int count = (wakePipe[0] >= 0) ? 2 : 1;
+    
+    char buf[64];
+    while (running.load()) {
+        // Without a wake pipe fall back to a timeout so stop() still works
+        int ready = ::poll(fds, count, (count == 2) ? -1 : 100);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (count == 2 && (fds[1].revents & POLLIN)) break;
+        if (!(fds[0].revents & (POLLIN | POLLHUP))) continue;
+        
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;   // EOF or error, nothing more to read
+        }
+        
+        KeyEvent event;
+        event.time = std::chrono::steady_clock::now();
+        for (ssize_t i = 0; i < n; i++) {
+            event.key = buf[i];
+            queue.push(event);   // drop keys if the game falls far behind
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef INPUTTHREAD_H
+#define INPUTTHREAD_H
+
+#include "SpscQueue.h"
+#include <termios.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+struct KeyEvent {
+    char key;
+    std::chrono::steady_clock::time_point time;
+};
+
+// Puts the terminal into non-canonical, no-echo mode for its lifetime. Ctrl-C
+// and termination signals restore the saved mode before the process dies.
+// One at a time.
+class RawTerminal {
+private:
+    struct termios saved;
+    bool active;
+    
+    void restoreHandlers();
+    
+public:
+    RawTerminal();
+    ~RawTerminal();
+    
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+};
+
+// Reads stdin on its own thread and queues every key press, so the game
+// loop never touches the terminal and can drain all input at once per tick
+class InputThread {
+private:
+    SpscQueue<KeyEvent, 256> queue;
+    std::thread worker;
+    std::atomic<bool> running;
+    int wakePipe[2];
+    std::unique_ptr<RawTerminal> raw;
+    
+public:
+    InputThread();
+    ~InputThread();
+    
+    // start() switches the terminal to raw mode, stop() restores it. Stop
+    // before reading from std::cin.
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(); }
+    
+    // Returns false once no more events are queued
+    bool poll(KeyEvent& event) { return queue.pop(event); }
+    
+private:
+    void run();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "Levels.h"
+
+void stampLevel(const LevelLayout& layout, BrickGrid& grid) {
+    grid.clear();
+    
+    int width = grid.getWidth();
+    for (int y = 0; y < layout.rows && y < grid.getHeight(); y++) {
+        const char* pattern = layout.cells + y * layout.period;
+        for (int x = 0; x < width; x++) {
+            BrickType type;
+            if (Brick::fromSymbol(pattern[x % layout.period], type)) {
+                grid.set(x, y, type);
+            }
+        }
+    }
+}
\ No newline at end of file
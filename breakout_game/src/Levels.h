@@ -0,0 +1,80 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include "BrickGrid.h"
+
+// Built-in level layouts. Each is a strip of rows, `period` cells wide and
+// written with the brick symbols, that repeats across the board from the
+// left edge. Rows below the last one stay empty.
+struct LevelLayout {
+    const char* cells;      // rows top to bottom, no separators
+    int period;
+    int rows;
+};
+
+constexpr LevelLayout LEVELS[] = {
+    // 1: the original wall
+    { "*@@*@@"
+      "#@#@#@"
+      "@@@@@@"
+      "@@@@@@", 6, 4 },
+    // 2: diagonal bands
+    { "#@@   "
+      " #@@  "
+      "  #@@ "
+      "   #@@"
+      "@   #@", 6, 5 },
+    // 3: a fortress with a gate in its roof
+    { "**  **"
+      "#@@@@#"
+      "#@##@#"
+      "#@@@@#"
+      "*    *"
+      "@@@@@@", 6, 6 }
+};
+
+constexpr int LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+// Compile-time checks on the tables above
+constexpr bool isLevelSymbol(char c) {
+    return c == ' ' || c == '@' || c == '#' || c == '*';
+}
+
+constexpr int layoutLength(const char* cells) {
+    return *cells == '\0' ? 0 : 1 + layoutLength(cells + 1);
+}
+
+constexpr bool validSymbols(const char* cells) {
+    return *cells == '\0' || (isLevelSymbol(*cells) && validSymbols(cells + 1));
+}
+
+constexpr bool hasBreakable(const char* cells) {
+    return *cells != '\0' && (*cells == '@' || *cells == '#' || hasBreakable(cells + 1));
+}
+
+constexpr bool validLayout(const LevelLayout& layout) {
+    return layout.period > 0 && layout.rows > 0 &&
+           layoutLength(layout.cells) == layout.period * layout.rows &&
+           validSymbols(layout.cells) && hasBreakable(layout.cells);
+}
+
+constexpr bool validLevels(int i) {
+    return i == LEVEL_COUNT || (validLayout(LEVELS[i]) && validLevels(i + 1));
+}
+
+static_assert(validLevels(0), "every level needs a whole number of rows of brick symbols "
+                              "and at least one breakable brick");
+
+// Index into LEVELS for a 1-based level; levels past the last one wrap around
+inline int levelIndex(int level) {
+    return level >= 1 ? (level - 1) % LEVEL_COUNT : 0;
+}
+
+inline const LevelLayout& levelLayout(int level) {
+    return LEVELS[levelIndex(level)];
+}
+
+// Fills grid, at its current size, with the layout
+void stampLevel(const LevelLayout& layout, BrickGrid& grid);
+
+#endif
\ No newline at end of file
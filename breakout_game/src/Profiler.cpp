@@ -0,0 +1,124 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+// Microseconds in a fixed width, with a decimal below 10 so short phases
+// don't all read 0
+std::string micros(uint64_t nanoseconds) {
+    char buf[32];
+    double us = nanoseconds / 1000.0;
+    std::snprintf(buf, sizeof(buf), us < 10 ? "%4.1f" : "%4.0f", us);
+    return buf;
+}
+
+}
+
+Histogram::Histogram() {
+    clear();
+}
+
+void Histogram::clear() {
+    std::fill(counts, counts + BUCKETS, 0);
+    count = 0;
+    total = 0;
+    max = 0;
+}
+
+void Histogram::record(uint64_t value) {
+    counts[bucketOf(value)]++;
+    count++;
+    total += value;
+    if (value > max) max = value;
+}
+
+// Values below 8 get a bucket each; above that, the leading bit picks the
+// power of two and the next three bits the bucket within it
+int Histogram::bucketOf(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<int>(value);
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = static_cast<int>((value >> (exponent - 3)) & (SUB_BUCKETS - 1));
+    return (exponent - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucketLimit(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    int exponent = bucket / SUB_BUCKETS + 2;
+    uint64_t sub = bucket % SUB_BUCKETS;
+    uint64_t width = 1ULL << (exponent - 3);
+    return ((SUB_BUCKETS + sub) << (exponent - 3)) + (width - 1);
+}
+
+uint64_t Histogram::percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count));
+    if (rank < 1) rank = 1;
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(bucketLimit(i), max);
+    }
+    return max;
+}
+
+Profiler::Profiler() : enabled(false) {}
+
+void Profiler::clear() {
+    for (int i = 0; i < static_cast<int>(Phase::COUNT); i++) {
+        phases[i].clear();
+    }
+    overlay.clear();
+}
+
+void Profiler::updateOverlay() {
+    static const Phase shown[3] = { Phase::INPUT, Phase::SIMULATE, Phase::RENDER };
+    static const char* labels[3] = { "in", "sim", "draw" };
+    
+    overlay.clear();
+    for (int i = 0; i < 3; i++) {
+        const Histogram& h = get(shown[i]);
+        if (!overlay.empty()) overlay += ' ';
+        overlay += labels[i];
+        overlay += ' ';
+        overlay += micros(h.percentile(50));
+        overlay += '/';
+        overlay += micros(h.percentile(99));
+    }
+    overlay += " us";
+}
+
+bool Profiler::dump(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    file << "{\n";
+    for (int i = 0; i < static_cast<int>(Phase::COUNT); i++) {
+        const Histogram& h = phases[i];
+        file << "  \"" << phaseName(static_cast<Phase>(i)) << "\": { \"count\": " << h.getCount()
+             << ", \"mean_us\": " << h.mean() / 1000.0
+             << ", \"p50_us\": " << h.percentile(50) / 1000.0
+             << ", \"p90_us\": " << h.percentile(90) / 1000.0
+             << ", \"p99_us\": " << h.percentile(99) / 1000.0
+             << ", \"max_us\": " << h.getMax() / 1000.0 << " }"
+             << (i + 1 < static_cast<int>(Phase::COUNT) ? "," : "") << "\n";
+    }
+    file << "}\n";
+    return static_cast<bool>(file);
+}
+
+const char* Profiler::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::INPUT: return "input";
+        case Phase::SIMULATE: return "simulate";
+        case Phase::RENDER: return "render";
+        case Phase::SLEEP: return "sleep";
+        case Phase::COUNT: break;
+    }
+    return "unknown";
+}
\ No newline at end of file
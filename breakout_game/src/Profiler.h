@@ -0,0 +1,99 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Log-linear latency histogram: eight buckets per power of two, so any
+// reported percentile is within 12.5% of the true value
+class Histogram {
+private:
+    static const int SUB_BUCKETS = 8;
+    static const int BUCKETS = 62 * SUB_BUCKETS;
+    
+    uint64_t counts[BUCKETS];
+    uint64_t count;
+    uint64_t total;
+    uint64_t max;
+    
+public:
+    Histogram();
+    
+    void clear();
+    void record(uint64_t value);
+    uint64_t getCount() const { return count; }
+    uint64_t getMax() const { return max; }
+    double mean() const { return count ? static_cast<double>(total) / count : 0; }
+    // Upper bound of the bucket holding the p-th percentile, p in [0, 100]
+    uint64_t percentile(double p) const;
+    
+private:
+    static int bucketOf(uint64_t value);
+    static uint64_t bucketLimit(int bucket);
+};
+
+// Phases of one pass through the game loop
+enum class Phase {
+    INPUT,
+    SIMULATE,
+    RENDER,
+    SLEEP,
+    COUNT
+};
+
+// Per-phase timings of the game loop. Disabled by default; while disabled
+// a ScopedTimer costs one predictable branch and no clock reads.
+class Profiler {
+private:
+    bool enabled;
+    Histogram phases[static_cast<int>(Phase::COUNT)];
+    std::string overlay;
+    
+public:
+    Profiler();
+    
+    void enable(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+    void record(Phase phase, uint64_t nanoseconds) {
+        phases[static_cast<int>(phase)].record(nanoseconds);
+    }
+    const Histogram& get(Phase phase) const { return phases[static_cast<int>(phase)]; }
+    void clear();
+    
+    // Fixed-width p50/p99 summary for the status line, rebuilt by updateOverlay()
+    const std::string& getOverlay() const { return overlay; }
+    void updateOverlay();
+    
+    // Writes every phase's count, mean, percentiles and max as JSON
+    bool dump(const std::string& path) const;
+    
+    static const char* phaseName(Phase phase);
+};
+
+// Times the enclosing scope into one phase
+class ScopedTimer {
+private:
+    typedef std::chrono::steady_clock Clock;
+    
+    Profiler& profiler;
+    Phase phase;
+    Clock::time_point start;
+    
+public:
+    ScopedTimer(Profiler& profiler, Phase phase) : profiler(profiler), phase(phase) {
+        if (profiler.isEnabled()) start = Clock::now();
+    }
+    
+    ~ScopedTimer() {
+        if (profiler.isEnabled()) {
+            profiler.record(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count());
+        }
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,362 @@
+#include "Renderer.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+namespace {
+
+volatile std::sig_atomic_t terminalResized = 0;
+
+void onWinch(int) {
+    terminalResized = 1;
+}
+
+// Unchanged cells shorter than this between two changed runs are resent
+// rather than paying for another cursor move
+const int MERGE_GAP = 4;
+
+// Past this many dirty cells a frame is recomposed in full instead, which
+// also keeps the pending list from ever growing
+const size_t MAX_PENDING = 1024;
+
+// Assumed when the output isn't a terminal, e.g. /dev/null in the benchmarks
+const int DEFAULT_ROWS = 24;
+const int DEFAULT_COLS = 80;
+// The viewport never gets smaller than this, however small the terminal
+const int MIN_VIEW = 8;
+
+}
+
+Renderer::Renderer(int fd)
+    : fd(fd), rows(0), cols(0), fullRepaint(true), recompose(true), termRows(0), termCols(0),
+      viewX(0), viewY(0), viewWidth(0), viewHeight(0) {
+    std::signal(SIGWINCH, onWinch);
+    pending.reserve(MAX_PENDING);
+}
+
+void Renderer::invalidate() {
+    fullRepaint = true;
+}
+
+void Renderer::track(const Simulation& sim) {
+    if (recompose) return;
+    if (sim.isBoardReset()) {
+        recompose = true;
+        pending.clear();
+        return;
+    }
+    const std::vector<Cell>& cells = sim.getDirtyCells();
+    if (pending.size() + cells.size() > MAX_PENDING) {
+        recompose = true;
+        pending.clear();
+        return;
+    }
+    pending.insert(pending.end(), cells.begin(), cells.end());
+}
+
+void Renderer::resize(int newRows, int newCols) {
+    rows = newRows;
+    cols = newCols;
+    front.assign(rows * cols, ' ');
+    back.assign(rows * cols, ' ');
+    fullRepaint = true;
+}
+
+void Renderer::queryTerminal() {
+    struct winsize size;
+    if (ioctl(fd, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        termRows = size.ws_row;
+        termCols = size.ws_col;
+    } else {
+        termRows = DEFAULT_ROWS;
+        termCols = DEFAULT_COLS;
+    }
+}
+
+// Fits the viewport to the terminal and keeps the play in it: the lowest
+// falling ball, any ball in flight, or else the paddle. Once that gets
+// within a quarter of the view from an edge the view is re-centred on it,
+// so scrolling happens in jumps rather than on every step. Returns true if
+// the view moved.
+bool Renderer::updateView(const Simulation& sim) {
+    const int width = sim.getWidth();
+    const int height = sim.getHeight();
+    int newWidth = std::min(width, std::max(MIN_VIEW, (termCols - 2) / 2));
+    int newHeight = std::min(height, std::max(MIN_VIEW, termRows - 4));
+    bool moved = (newWidth != viewWidth || newHeight != viewHeight);
+    viewWidth = newWidth;
+    viewHeight = newHeight;
+    
+    Cell focus(sim.getPaddleX() + sim.getPaddleWidth() / 2, height - 1);
+    const BallStore& balls = sim.getBalls();
+    double lowest = -1;
+    for (size_t i = 0; i < balls.size(); i++) {
+        if (balls.flags[i] & BallStore::ATTACHED) continue;
+        double rank = (balls.dy[i] > 0) ? height + balls.y[i] : 0;
+        if (rank > lowest) {
+            lowest = rank;
+            focus = sim.getBallCell(balls.get(i));
+        }
+    }
+    
+    int newX = viewX;
+    int newY = viewY;
+    int marginX = viewWidth / 4;
+    int marginY = viewHeight / 4;
+    if (focus.x < viewX + marginX || focus.x >= viewX + viewWidth - marginX) {
+        newX = focus.x - viewWidth / 2;
+    }
+    if (focus.y < viewY + marginY || focus.y >= viewY + viewHeight - marginY) {
+        newY = focus.y - viewHeight / 2;
+    }
+    newX = std::max(0, std::min(newX, width - viewWidth));
+    newY = std::max(0, std::min(newY, height - viewHeight));
+    moved = moved || newX != viewX || newY != viewY;
+    viewX = newX;
+    viewY = newY;
+    return moved;
+}
+
+void Renderer::render(const Simulation& sim, bool paused) {
+    if (terminalResized || termRows == 0) {
+        terminalResized = 0;
+        queryTerminal();
+        fullRepaint = true;
+    }
+    if (updateView(sim)) {
+        recompose = true;
+        pending.clear();
+    }
+    
+    // Status line + border + board rows + border + controls line
+    int newRows = viewHeight + 4;
+    int newCols = viewWidth * 2 + 2;
+    if (newCols < 64) newCols = 64;
+    // Room for the overlay after "Score: ... | Level: ... | View: ..."
+    int statusCols = 60 + static_cast<int>(overlay.size());
+    if (!overlay.empty() && newCols < statusCols) newCols = statusCols;
+    if (newRows != rows || newCols != cols) {
+        resize(newRows, newCols);
+    }
+    
+    out.clear();
+    if (fullRepaint || recompose) {
+        compose(sim, paused);
+        if (fullRepaint) {
+            emitFull();
+        } else {
+            emitDiff(0, rows - 1);
+        }
+        fullRepaint = false;
+        recompose = false;
+    } else {
+        // Redraw what is under the dirty cells, then put every ball back on
+        // top; cells that end up unchanged are skipped by emitCell()
+        for (size_t i = 0; i < pending.size(); i++) {
+            drawCell(sim, pending[i].x, pending[i].y);
+        }
+        drawBalls(sim);
+        for (size_t i = 0; i < pending.size(); i++) {
+            emitCell(pending[i].x, pending[i].y);
+        }
+        const BallStore& balls = sim.getBalls();
+        for (size_t i = 0; i < balls.size(); i++) {
+            if (balls.flags[i] & BallStore::ATTACHED) continue;
+            Cell cell = sim.getBallCell(balls.get(i));
+            emitCell(cell.x, cell.y);
+        }
+        composeStatus(sim, paused);
+        emitDiff(0, 0);
+        emitDiff(rows - 1, rows - 1);
+    }
+    pending.clear();
+    
+    if (!out.empty()) {
+        // Leave the cursor below the frame so any following text lands there
+        moveCursor(rows, 0);
+        flush();
+    }
+    front = back;
+}
+
+int Renderer::putText(int row, int col, const char* text, size_t length) {
+    int n = static_cast<int>(length);
+    if (n > cols - col) n = cols - col;
+    if (n <= 0) return col;
+    std::memcpy(&back[row * cols + col], text, n);
+    return col + n;
+}
+
+void Renderer::compose(const Simulation& sim, bool paused) {
+    const int width = sim.getWidth();
+    const int height = sim.getHeight();
+    const int paddleX = sim.getPaddleX();
+    const int paddleWidth = sim.getPaddleWidth();
+    
+    std::fill(back.begin(), back.end(), ' ');
+    
+    // Borders are solid on the board's edges and dotted where the board
+    // goes on past the view
+    composeStatus(sim, paused);
+    std::fill_n(&back[cols], viewWidth * 2 + 2, viewY == 0 ? '-' : '.');
+    std::fill_n(&back[(viewHeight + 2) * cols], viewWidth * 2 + 2,
+                viewY + viewHeight == height ? '-' : '.');
+    
+    // Layers from bottom to top: walls, paddle, bricks, balls
+    char left = (viewX == 0) ? '|' : ':';
+    char right = (viewX + viewWidth == width) ? '|' : ':';
+    for (int y = 0; y < viewHeight; y++) {
+        char* line = &back[(y + 2) * cols];
+        line[0] = left;
+        line[viewWidth * 2 + 1] = right;
+    }
+    
+    for (int x = paddleX; x < paddleX + paddleWidth && x < width; x++) {
+        if (!visible(x, height - 1)) continue;
+        char* cell = &back[cellOffset(x, height - 1)];
+        cell[0] = cell[1] = '-';
+    }
+    
+    char* frame = back.data();
+    sim.getBricks().forEachBrickIn(viewX, viewY, viewX + viewWidth - 1, viewY + viewHeight - 1,
+                                   [this, frame](int x, int y, Brick brick) {
+        char* cell = frame + cellOffset(x, y);
+        cell[0] = cell[1] = static_cast<char>(brick.type());
+    });
+    
+    drawBalls(sim);
+}
+
+void Renderer::drawBalls(const Simulation& sim) {
+    const BallStore& balls = sim.getBalls();
+    for (size_t i = 0; i < balls.size(); i++) {
+        if (balls.flags[i] & BallStore::ATTACHED) continue;
+        Cell pos = sim.getBallCell(balls.get(i));
+        if (visible(pos.x, pos.y)) {
+            char* cell = &back[cellOffset(pos.x, pos.y)];
+            cell[0] = '(';
+            cell[1] = ')';
+        }
+    }
+}
+
+void Renderer::composeStatus(const Simulation& sim, bool paused) {
+    std::fill(back.begin(), back.begin() + cols, ' ');
+    std::fill(back.end() - cols, back.end(), ' ');
+    
+    // Draw score and status; formatted on the stack, as this runs every frame
+    char status[96];
+    int length = std::snprintf(status, sizeof(status), "Score: %d | Lives: %d | Level: %d",
+                               sim.getScore(), sim.getLives(), sim.getLevel());
+    if (viewWidth < sim.getWidth() || viewHeight < sim.getHeight()) {
+        length += std::snprintf(status + length, sizeof(status) - length, " | View: %d,%d",
+                                viewX, viewY);
+    }
+    int col = putText(0, 0, status, std::min<size_t>(length, sizeof(status) - 1));
+    if (!overlay.empty()) {
+        col = putText(0, col, " | ");
+        putText(0, col, overlay.data(), overlay.size());
+    }
+    
+    if (paused) {
+        putText(rows - 1, 0, "PAUSED - Press 'p' to continue, 's' to save, 'r' to restart");
+    } else {
+        putText(rows - 1, 0, "Controls: a-left, d-right, space-launch, p-pause, r-restart");
+    }
+}
+
+// Redraws one board cell with the same layering as compose(), minus the
+// balls, which drawBalls() adds afterwards
+void Renderer::drawCell(const Simulation& sim, int x, int y) {
+    if (!visible(x, y)) return;
+    
+    char* cell = &back[cellOffset(x, y)];
+    Brick brick = sim.getBricks().at(x, y);
+    
+    if (!brick.empty()) {
+        cell[0] = cell[1] = static_cast<char>(brick.type());
+    } else if (y == sim.getHeight() - 1 && x >= sim.getPaddleX() &&
+               x < sim.getPaddleX() + sim.getPaddleWidth()) {
+        cell[0] = cell[1] = '-';
+    } else {
+        cell[0] = cell[1] = ' ';
+    }
+}
+
+void Renderer::emitFull() {
+    // Whatever was printed through std::cout has to reach the terminal first
+    std::cout.flush();
+    out += "\033[2J";
+    for (int r = 0; r < rows; r++) {
+        moveCursor(r, 0);
+        const char* line = &back[r * cols];
+        int len = cols;
+        while (len > 0 && line[len - 1] == ' ') len--;
+        out.append(line, len);
+    }
+}
+
+void Renderer::emitDiff(int firstRow, int lastRow) {
+    for (int r = firstRow; r <= lastRow; r++) {
+        const char* oldLine = &front[r * cols];
+        const char* newLine = &back[r * cols];
+        int c = 0;
+        while (c < cols) {
+            if (oldLine[c] == newLine[c]) {
+                c++;
+                continue;
+            }
+            int start = c;
+            int end = c + 1;
+            int gap = 0;
+            for (int i = end; i < cols && gap < MERGE_GAP; i++) {
+                if (oldLine[i] != newLine[i]) {
+                    end = i + 1;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+            }
+            moveCursor(r, start);
+            out.append(newLine + start, end - start);
+            c = end;
+        }
+    }
+}
+
+void Renderer::emitCell(int x, int y) {
+    if (!visible(x, y)) return;
+    
+    size_t pos = cellOffset(x, y);
+    if (front[pos] == back[pos] && front[pos + 1] == back[pos + 1]) return;
+    
+    moveCursor(y - viewY + 2, 1 + (x - viewX) * 2);
+    out.append(&back[pos], 2);
+    front[pos] = back[pos];
+    front[pos + 1] = back[pos + 1];
+}
+
+void Renderer::moveCursor(int row, int col) {
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "\033[%d;%dH", row + 1, col + 1);
+    out.append(buf, n);
+}
+
+void Renderer::flush() {
+    const char* p = out.data();
+    size_t left = out.size();
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        p += n;
+        left -= n;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "Simulation.h"
+#include <vector>
+#include <string>
+#include <cstring>
+
+// Double-buffered terminal renderer. Each frame is composed off-screen and
+// only the cells that differ from the previous frame are sent, as
+// cursor-addressed runs in a single write(). Between full recomposes only
+// the cells reported dirty by the simulation are redrawn.
+//
+// Boards larger than the terminal are shown through a viewport that
+// follows the play, so the cost of a frame depends on the visible area
+// only.
+class Renderer {
+private:
+    int fd;
+    int rows, cols;
+    std::vector<char> front;   // what the terminal currently shows
+    std::vector<char> back;    // frame being composed
+    std::string out;
+    bool fullRepaint;
+    bool recompose;            // board was replaced, dirty list is not enough
+    std::vector<Cell> pending; // dirty cells since the last frame
+    std::string overlay;       // extra status line text, e.g. profiler numbers
+    int termRows, termCols;    // terminal size, 0 until queried
+    int viewX, viewY;          // board cell shown at the top left
+    int viewWidth, viewHeight; // board cells shown
+
+public:
+    explicit Renderer(int fd);
+    
+    // Collects the dirty cells of a step; call after every Simulation::step
+    void track(const Simulation& sim);
+    void render(const Simulation& sim, bool paused);
+    // Forces a full repaint, e.g. after other text was printed to the terminal
+    void invalidate();
+    void setOverlay(const std::string& text) { overlay = text; }
+
+private:
+    void resize(int newRows, int newCols);
+    void queryTerminal();
+    bool updateView(const Simulation& sim);
+    bool visible(int x, int y) const {
+        return x >= viewX && x < viewX + viewWidth && y >= viewY && y < viewY + viewHeight;
+    }
+    // Offset of board cell (x, y) in the frame buffers
+    size_t cellOffset(int x, int y) const {
+        return static_cast<size_t>(y - viewY + 2) * cols + 1 + (x - viewX) * 2;
+    }
+    void compose(const Simulation& sim, bool paused);
+    void composeStatus(const Simulation& sim, bool paused);
+    void drawCell(const Simulation& sim, int x, int y);
+    void drawBalls(const Simulation& sim);
+    // Returns the column after the last character written
+    int putText(int row, int col, const char* text, size_t length);
+    int putText(int row, int col, const char* text) { return putText(row, col, text, std::strlen(text)); }
+    void emitFull();
+    void emitDiff(int firstRow, int lastRow);
+    void emitCell(int x, int y);
+    void moveCursor(int row, int col);
+    void flush();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "Replay.h"
+#include "Renderer.h"
+#include "Spectator.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// File layout: header, the endgame cells when HAS_ENDGAME is set, the
+// events, then the footer. Host byte order. Up to version 2 the endgame is
+// width * height dense cells; from version 3 it is sparse chunks as
+// BrickGrid::appendChunks() writes them.
+struct FileHeader {
+    char magic[4];          // "BKRP"
+    uint16_t version;
+    uint16_t flags;
+    uint32_t width;
+    uint32_t height;
+    int32_t startLevel;
+    int32_t endgameLevel;
+    int32_t tickRate;
+    uint32_t eventCount;
+    uint64_t seed;
+    double ballStep;
+};
+
+// Follows the header from version 2 on; version 1 files predate multi-ball
+struct MultiBallHeader {
+    double powerUpChance;
+    uint32_t maxBalls;
+    uint32_t reserved;
+};
+
+struct FileFooter {
+    uint64_t ticks;
+    int32_t score;
+    int32_t lives;
+    int32_t level;
+    uint32_t boardChecksum;
+};
+
+const char REPLAY_MAGIC[4] = { 'B', 'K', 'R', 'P' };
+const uint16_t REPLAY_VERSION = 3;
+const uint16_t HAS_ENDGAME = 1;
+const uint16_t FIXED_POINT = 2;     // played with Simulation::setFixedPoint(true)
+
+const uint8_t INPUT_LAUNCH = 1;
+const uint8_t INPUT_RESTART = 2;
+
+bool readEndGameCells(std::ifstream& file, uint16_t version, BrickGrid& bricks) {
+    std::vector<unsigned char> data;
+    if (version < 3) {
+        data.resize(bricks.area());
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size())) return false;
+        bricks.assignDense(reinterpret_cast<const Brick*>(data.data()), bricks.getWidth(),
+                           bricks.getHeight());
+        return true;
+    }
+    
+    uint32_t count;
+    if (!file.read(reinterpret_cast<char*>(&count), 4) ||
+        count > static_cast<uint32_t>(bricks.getChunksX() * bricks.getChunksY())) {
+        return false;
+    }
+    data.resize(4 + static_cast<size_t>(count) * BrickGrid::CHUNK_RECORD);
+    std::memcpy(data.data(), &count, 4);
+    if (!file.read(reinterpret_cast<char*>(data.data()) + 4, data.size() - 4)) return false;
+    return bricks.readChunks(data.data(), data.size()) == data.size();
+}
+
+void printResult(const Replay& replay, const Simulation& sim) {
+    if (replay.matches(sim)) {
+        std::cout << "Replay verified: score " << sim.getScore() << ", lives " << sim.getLives()
+                  << ", level " << sim.getLevel() << " after " << sim.getTick() << " ticks" << std::endl;
+    } else {
+        std::cout << "Replay MISMATCH" << std::endl;
+        std::cout << "  recorded: score " << replay.score << ", lives " << replay.lives
+                  << ", level " << replay.level << ", ticks " << replay.ticks
+                  << ", board " << replay.boardChecksum << std::endl;
+        std::cout << "  replayed: score " << sim.getScore() << ", lives " << sim.getLives()
+                  << ", level " << sim.getLevel() << ", ticks " << sim.getTick()
+                  << ", board " << sim.getBricks().checksum() << std::endl;
+    }
+}
+
+}
+
+Replay::Replay()
+    : seed(0), ballStep(1.0), powerUpChance(0), maxBalls(1), tickRate(60), width(9), height(18), startLevel(1),
+      fixedPoint(false), hasEndGame(false), ticks(0), score(0), lives(0), level(0), boardChecksum(0) {}
+
+void Replay::begin(const Simulation& sim, uint64_t seedUsed, int rate, int firstLevel,
+                   const EndGame* played) {
+    seed = seedUsed;
+    ballStep = sim.getBallStep();
+    powerUpChance = sim.getPowerUpChance();
+    maxBalls = sim.getMaxBalls();
+    tickRate = rate;
+    width = sim.getWidth();
+    height = sim.getHeight();
+    startLevel = firstLevel;
+    fixedPoint = sim.isFixedPoint();
+    hasEndGame = (played != nullptr);
+    if (played) {
+        endgame = *played;
+    }
+    events.clear();
+    ticks = 0;
+}
+
+void Replay::record(const Simulation& sim, const Input& input) {
+    if (input.move == 0 && !input.launch && !input.restart) return;
+    
+    ReplayEvent event;
+    event.tick = static_cast<uint32_t>(sim.getTick());
+    event.move = static_cast<int16_t>(input.move);
+    event.flags = (input.launch ? INPUT_LAUNCH : 0) | (input.restart ? INPUT_RESTART : 0);
+    event.reserved = 0;
+    events.push_back(event);
+}
+
+void Replay::finish(const Simulation& sim) {
+    ticks = sim.getTick();
+    score = sim.getScore();
+    lives = sim.getLives();
+    level = sim.getLevel();
+    boardChecksum = sim.getBricks().checksum();
+}
+
+void Replay::setup(Simulation& sim) const {
+    sim.resize(width, height);
+    sim.setFixedPoint(fixedPoint);
+    sim.setBallStep(ballStep);
+    sim.setPowerUps(powerUpChance, maxBalls);
+    sim.seed(seed);
+    sim.reset(startLevel);
+    if (hasEndGame) {
+        sim.loadEndGame(endgame);
+    }
+}
+
+Input Replay::inputAt(size_t index) const {
+    Input input;
+    input.move = events[index].move;
+    input.launch = (events[index].flags & INPUT_LAUNCH) != 0;
+    input.restart = (events[index].flags & INPUT_RESTART) != 0;
+    return input;
+}
+
+bool Replay::matches(const Simulation& sim) const {
+    return static_cast<uint64_t>(sim.getTick()) == ticks && sim.getScore() == score &&
+           sim.getLives() == lives && sim.getLevel() == level &&
+           sim.getBricks().checksum() == boardChecksum;
+}
+
+bool Replay::saveToFile(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    FileHeader header;
+    std::memcpy(header.magic, REPLAY_MAGIC, 4);
+    header.version = REPLAY_VERSION;
+    header.flags = (hasEndGame ? HAS_ENDGAME : 0) | (fixedPoint ? FIXED_POINT : 0);
+    header.width = width;
+    header.height = height;
+    header.startLevel = startLevel;
+    header.endgameLevel = hasEndGame ? endgame.initialLevel : 0;
+    header.tickRate = tickRate;
+    header.eventCount = static_cast<uint32_t>(events.size());
+    header.seed = seed;
+    header.ballStep = ballStep;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    MultiBallHeader multiBall;
+    multiBall.powerUpChance = powerUpChance;
+    multiBall.maxBalls = maxBalls;
+    multiBall.reserved = 0;
+    file.write(reinterpret_cast<const char*>(&multiBall), sizeof(multiBall));
+    
+    if (hasEndGame) {
+        std::string chunks;
+        endgame.bricks.appendChunks(chunks);
+        file.write(chunks.data(), chunks.size());
+    }
+    if (!events.empty()) {
+        file.write(reinterpret_cast<const char*>(&events[0]), events.size() * sizeof(ReplayEvent));
+    }
+    
+    FileFooter footer;
+    footer.ticks = ticks;
+    footer.score = score;
+    footer.lives = lives;
+    footer.level = level;
+    footer.boardChecksum = boardChecksum;
+    file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    return static_cast<bool>(file);
+}
+
+bool Replay::loadFromFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, REPLAY_MAGIC, 4) != 0 || header.version == 0 ||
+        header.version > REPLAY_VERSION || header.width == 0 || header.height == 0 ||
+        header.width > static_cast<uint32_t>(EndGame::MAX_SIZE) ||
+        header.height > static_cast<uint32_t>(EndGame::MAX_SIZE)) {
+        return false;
+    }
+    
+    powerUpChance = 0;
+    maxBalls = 1;
+    if (header.version >= 2) {
+        MultiBallHeader multiBall;
+        if (!file.read(reinterpret_cast<char*>(&multiBall), sizeof(multiBall))) {
+            return false;
+        }
+        powerUpChance = multiBall.powerUpChance;
+        maxBalls = multiBall.maxBalls;
+    }
+    
+    seed = header.seed;
+    ballStep = header.ballStep;
+    tickRate = header.tickRate > 0 ? header.tickRate : 60;
+    width = header.width;
+    height = header.height;
+    startLevel = header.startLevel;
+    hasEndGame = (header.flags & HAS_ENDGAME) != 0;
+    fixedPoint = (header.flags & FIXED_POINT) != 0;
+    
+    if (hasEndGame) {
+        if (header.endgameLevel < 1) {
+            return false;
+        }
+        endgame.filename = "replay";
+        endgame.width = width;
+        endgame.height = height;
+        endgame.initialLevel = header.endgameLevel;
+        endgame.bricks.resize(width, height);
+        if (!readEndGameCells(file, header.version, endgame.bricks)) {
+            return false;
+        }
+    }
+    
+    events.resize(header.eventCount);
+    if (!events.empty() &&
+        !file.read(reinterpret_cast<char*>(&events[0]), events.size() * sizeof(ReplayEvent))) {
+        return false;
+    }
+    
+    FileFooter footer;
+    if (!file.read(reinterpret_cast<char*>(&footer), sizeof(footer))) {
+        return false;
+    }
+    ticks = footer.ticks;
+    score = footer.score;
+    lives = footer.lives;
+    level = footer.level;
+    boardChecksum = footer.boardChecksum;
+    return true;
+}
+
+int runReplay(const std::string& path, int speed) {
+    Replay replay;
+    if (!replay.loadFromFile(path)) {
+        std::cerr << "Failed to load replay: " << path << std::endl;
+        return 1;
+    }
+    
+    Simulation sim(replay.width, replay.height);
+    replay.setup(sim);
+    size_t next = 0;
+    
+    if (speed <= 0) {
+        // Headless: no rendering, no sleeping
+        auto start = std::chrono::steady_clock::now();
+        while (static_cast<uint64_t>(sim.getTick()) < replay.ticks) {
+            Input input;
+            if (next < replay.events.size() && replay.events[next].tick == sim.getTick()) {
+                input = replay.inputAt(next++);
+            }
+            sim.step(input);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Replayed " << sim.getTick() << " ticks in " << seconds * 1000 << " ms" << std::endl;
+    } else {
+        if (speed > 100) speed = 100;
+        typedef std::chrono::steady_clock Clock;
+        const Clock::duration tick = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / (replay.tickRate * speed)));
+        const Clock::duration frame = std::chrono::milliseconds(33);
+        
+        Renderer renderer(STDOUT_FILENO);
+        SpectatorFeed spectators;
+        spectators.open();
+        spectators.publish(sim, false);
+        Clock::time_point nextTick = Clock::now();
+        Clock::time_point nextFrame = nextTick;
+        while (static_cast<uint64_t>(sim.getTick()) < replay.ticks) {
+            // At high speeds several ticks are due per wake-up
+            while (Clock::now() >= nextTick && static_cast<uint64_t>(sim.getTick()) < replay.ticks) {
+                Input input;
+                if (next < replay.events.size() && replay.events[next].tick == sim.getTick()) {
+                    input = replay.inputAt(next++);
+                }
+                sim.step(input);
+                renderer.track(sim);
+                spectators.publish(sim, false);
+                nextTick += tick;
+            }
+            if (Clock::now() >= nextFrame) {
+                renderer.render(sim, false);
+                nextFrame = Clock::now() + frame;
+            }
+            std::this_thread::sleep_until(nextTick < nextFrame ? nextTick : nextFrame);
+        }
+        renderer.render(sim, false);
+    }
+    
+    printResult(replay, sim);
+    return replay.matches(sim) ? 0 : 2;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "Simulation.h"
+#include "EndGame.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Input applied on one tick; ticks without input are not stored
+struct ReplayEvent {
+    uint32_t tick;
+    int16_t move;
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+// A recorded session: everything needed to rebuild the starting state, the
+// input log keyed by tick, and the final state to verify a re-run against
+struct Replay {
+    uint64_t seed;
+    double ballStep;
+    double powerUpChance;
+    int maxBalls;
+    int tickRate;           // only used for real-time playback
+    int width, height;
+    int startLevel;
+    bool fixedPoint;
+    bool hasEndGame;
+    EndGame endgame;
+    std::vector<ReplayEvent> events;
+    
+    // Final state
+    uint64_t ticks;
+    int score, lives, level;
+    uint32_t boardChecksum;
+    
+    Replay();
+    
+    // Call right after the simulation was seeded and reset
+    void begin(const Simulation& sim, uint64_t seedUsed, int rate, int firstLevel,
+               const EndGame* played);
+    // Call before sim.step(input)
+    void record(const Simulation& sim, const Input& input);
+    void finish(const Simulation& sim);
+    
+    // Rebuilds the starting state recorded by begin()
+    void setup(Simulation& sim) const;
+    Input inputAt(size_t index) const;
+    bool matches(const Simulation& sim) const;
+    
+    bool saveToFile(const std::string& path) const;
+    bool loadFromFile(const std::string& path);
+};
+
+// breakout --replay: speed 0 re-runs headlessly as fast as possible,
+// 1-100 plays back on the terminal at that multiple of real time
+int runReplay(const std::string& path, int speed);
+
+#endif
\ No newline at end of file
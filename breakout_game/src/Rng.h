@@ -0,0 +1,35 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Small deterministic generator (SplitMix64). Same seed, same sequence on
+// every platform and build, unlike rand().
+class Rng {
+private:
+    uint64_t state;
+    
+public:
+    explicit Rng(uint64_t seed = 0) : state(seed) {}
+    
+    void seed(uint64_t s) { state = s; }
+    
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    
+    // Uniform integer in [0, n)
+    int below(int n) {
+        return static_cast<int>(next() % static_cast<uint64_t>(n));
+    }
+    
+    // Uniform double in [0, 1)
+    double unit() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+#endif
\ No newline at end of file
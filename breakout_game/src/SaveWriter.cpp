@@ -0,0 +1,48 @@
+#include "SaveWriter.h"
+
+SaveWriter::SaveWriter() : stopping(false) {
+    worker = std::thread(&SaveWriter::run, this);
+}
+
+SaveWriter::~SaveWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void SaveWriter::submit(const std::string& what, const std::function<bool()>& write) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Job job;
+        job.what = what;
+        job.write = write;
+        jobs.push_back(job);
+    }
+    wake.notify_one();
+}
+
+bool SaveWriter::poll(std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (results.empty()) return false;
+    message = results.front();
+    results.pop_front();
+    return true;
+}
+
+void SaveWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) break;    // stopping, and everything is written
+        
+        Job job = jobs.front();
+        jobs.pop_front();
+        lock.unlock();
+        bool ok = job.write();
+        lock.lock();
+        results.push_back((ok ? "Saved " : "Failed to save ") + job.what);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef SAVEWRITER_H
+#define SAVEWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs file saves on a background thread, one at a time in submission
+// order, so the caller never waits on the disk. Jobs must only touch data
+// they own, typically a snapshot captured by value.
+class SaveWriter {
+private:
+    struct Job {
+        std::string what;               // e.g. "endgame foo", used in the result message
+        std::function<bool()> write;
+    };
+    
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::deque<std::string> results;
+    bool stopping;
+    std::thread worker;
+    
+public:
+    SaveWriter();
+    // Finishes every queued job before returning
+    ~SaveWriter();
+    
+    void submit(const std::string& what, const std::function<bool()>& write);
+    // Returns false once no more results are waiting
+    bool poll(std::string& message);
+    
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+    
+private:
+    void run();
+};
+
+#endif
\ No newline at end of file
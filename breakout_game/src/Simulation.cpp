@@ -0,0 +1,657 @@
+#include "Simulation.h"
+#include "BoardShape.h"
+#include "Fixed.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Upper bound on bounces resolved within one tick, in case the ball gets
+// wedged between bricks
+const int MAX_CONTACTS = 16;
+
+const double NEVER = std::numeric_limits<double>::infinity();
+
+// Grid cell the ball is in, taking its direction into account when it sits
+// exactly on a cell boundary
+int cellIndex(double pos, double velocity) {
+    double cell = std::floor(pos);
+    if (velocity < 0 && cell == pos) cell -= 1;
+    return static_cast<int>(cell);
+}
+
+int sign(double v) {
+    return (v > 0) - (v < 0);
+}
+
+// Fastest sideways speed a paddle return can give the ball
+const double MAX_DX = 1.5;
+
+// cellIndex() for 16.16 positions
+int fixedCell(int64_t pos, int64_t velocity) {
+    int cell = Fixed::floorCell(pos);
+    if (velocity < 0 && static_cast<int64_t>(cell) * Fixed::ONE == pos) cell -= 1;
+    return cell;
+}
+
+int64_t absolute(int64_t v) {
+    return (v < 0) ? -v : v;
+}
+
+}
+
+Simulation::Simulation(int width, int height)
+    : width(width), height(height), paddleWidth(3), kernel(BallStore::bestKernel()), fixedPoint(false),
+      ballStep(1.0), powerUpChance(0), maxBalls(1), bricks(width, height), liveBricks(0), score(0),
+      lives(3), level(1), tick(0), hasEndGame(false), endgameLevel(0), boardReset(true) {
+    paddleX = width / 2;
+    balls.push(Ball());
+    dirty.reserve(64);
+}
+
+void Simulation::setBallStep(double cellsPerTick) {
+    ballStep = fixedPoint ? Fixed::quantize(cellsPerTick) : cellsPerTick;
+}
+
+void Simulation::setFixedPoint(bool on) {
+    fixedPoint = on;
+    setBallStep(ballStep);
+}
+
+void Simulation::setPowerUps(double chance, int limit) {
+    powerUpChance = chance;
+    maxBalls = limit;
+    balls.reserve(limit);
+    spawned.reserve(limit);
+    ballCells.reserve(limit);
+}
+
+void Simulation::resize(int w, int h) {
+    width = w;
+    height = h;
+    paddleX = width / 2 - paddleWidth / 2;
+    bricks.resize(w, h);
+    for (int i = 0; i < LEVEL_COUNT; i++) {
+        levelBoards[i] = BrickGrid();
+    }
+    liveBricks = 0;
+    boardReset = true;
+}
+
+void Simulation::reset(int startLevel) {
+    score = 0;
+    lives = 3;
+    level = startLevel;
+    tick = 0;
+    hasEndGame = false;
+    endgameLevel = 0;
+    
+    // Initialize paddle
+    paddleX = width / 2 - paddleWidth / 2;
+    
+    // Build every layout now, so level changes and restarts only copy
+    prepareLevels();
+    loadLevel();
+}
+
+void Simulation::loadEndGame(const EndGame& endgame) {
+    if (endgame.width != width || endgame.height != height) {
+        resize(endgame.width, endgame.height);
+    }
+    endgameBoard = endgame.bricks;
+    hasEndGame = true;
+    endgameLevel = endgame.initialLevel;
+    level = endgameLevel;
+    loadLevel();
+}
+
+void Simulation::mirror(const BrickGrid& board, const BallStore& state, int paddle, int newScore,
+                        int newLives, int newLevel, long ticks) {
+    if (board.getWidth() != width || board.getHeight() != height) {
+        resize(board.getWidth(), board.getHeight());
+    }
+    bricks = board;
+    balls = state;
+    if (balls.empty()) resetBall();
+    paddleX = paddle;
+    score = newScore;
+    lives = newLives;
+    level = newLevel;
+    tick = ticks;
+    countLiveBricks();
+    dirty.clear();
+    boardReset = true;
+}
+
+StepEvent Simulation::step(const Input& input) {
+    tick++;
+    dirty.clear();
+    boardReset = false;
+    
+    int oldPaddleX = paddleX;
+    bool wasAttached = (balls.flags[0] & BallStore::ATTACHED) != 0;
+    
+    applyInput(input);
+    
+    StepEvent event = StepEvent::NONE;
+    if (balls.flags[0] & BallStore::ATTACHED) {
+        balls.x[0] = paddleX + paddleWidth / 2.0;
+    } else {
+        if (wasAttached) {
+            dirty.push_back(getBallCell(balls.get(0)));   // just launched
+        }
+        if (!moveBalls()) {
+            event = StepEvent::GAME_OVER;
+        } else if (liveBricks == 0) {
+            event = nextLevel();
+        }
+    }
+    
+    markPaddle(oldPaddleX);
+    return event;
+}
+
+long Simulation::fastForward(long maxTicks) {
+    if ((balls.flags[0] & BallStore::ATTACHED) || maxTicks <= 0) return 0;
+    
+    // Stop strictly before the first contact of any ball so the next
+    // step() resolves it
+    double t = static_cast<double>(maxTicks) + 1;
+    for (size_t i = 0; i < balls.size() && t >= 1; i++) {
+        t = timeToContact(balls.get(i), t);
+    }
+    long ticks = static_cast<long>(std::ceil(t)) - 1;
+    // The contact time is worked out in floating point; fixed point keeps
+    // a tick clear of it so that rounding can't matter
+    if (fixedPoint) ticks--;
+    if (ticks > maxTicks) ticks = maxTicks;
+    if (ticks <= 0) return 0;
+    
+    dirty.clear();
+    boardReset = false;
+    tick += ticks;
+    const int64_t step = Fixed::fromDouble(ballStep);
+    for (size_t i = 0; i < balls.size(); i++) {
+        Ball ball = balls.get(i);
+        Cell before = getBallCell(ball);
+        if (fixedPoint) {
+            // Free flight adds the same velocity every tick
+            ball.x = Fixed::toDouble(Fixed::fromDouble(ball.x) +
+                                     Fixed::mul(Fixed::fromDouble(ball.dx), step) * ticks);
+            ball.y = Fixed::toDouble(Fixed::fromDouble(ball.y) +
+                                     Fixed::mul(Fixed::fromDouble(ball.dy), step) * ticks);
+        } else {
+            ball.x += ball.dx * ballStep * ticks;
+            ball.y += ball.dy * ballStep * ticks;
+        }
+        balls.set(i, ball);
+        markBall(before, getBallCell(ball));
+    }
+    return ticks;
+}
+
+Cell Simulation::getBallCell(const Ball& ball) const {
+    int x = static_cast<int>(std::floor(ball.x));
+    return Cell((x >= width) ? width - 1 : x, static_cast<int>(std::floor(ball.y)));
+}
+
+void Simulation::markPaddle(int oldX) {
+    if (oldX == paddleX) return;
+    
+    int from = (oldX < paddleX) ? oldX : paddleX;
+    int to = ((oldX > paddleX) ? oldX : paddleX) + paddleWidth;
+    for (int x = from; x < to; x++) {
+        dirty.push_back(Cell(x, height - 1));
+    }
+}
+
+void Simulation::markBall(const Cell& before, const Cell& after) {
+    if (before.x == after.x && before.y == after.y) return;
+    
+    dirty.push_back(before);
+    dirty.push_back(after);
+}
+
+void Simulation::applyInput(const Input& input) {
+    paddleX += input.move;
+    if (paddleX < 0) paddleX = 0;
+    if (paddleX > width - paddleWidth) paddleX = width - paddleWidth;
+    
+    if (input.launch && (balls.flags[0] & BallStore::ATTACHED)) {
+        balls.flags[0] = 0;
+        balls.dx[0] = (rng.below(3) - 1) * 0.5; // -0.5, 0, or 0.5
+        balls.dy[0] = -1.0;
+    }
+    
+    if (input.restart) {
+        loadLevel();
+    }
+}
+
+bool Simulation::brickAt(int x, int y) const {
+    return bricks.inside(x, y) && bricks.occupied(x, y);
+}
+
+// Returns true when the hit destroyed the brick and earned a split
+bool Simulation::hitBrick(int x, int y) {
+    bool wasBreakable = bricks.at(x, y).breakable();
+    score += bricks.hit(x, y);
+    dirty.push_back(Cell(x, y));
+    if (!wasBreakable || !bricks.at(x, y).empty()) {
+        return false;
+    }
+    liveBricks--;
+    // No draw at all when power-ups are off, so the random stream matches
+    // single-ball games
+    return powerUpChance > 0 && rng.unit() < powerUpChance;
+}
+
+// Adds two copies of the ball fanned out to either side of it. They join
+// the game at the end of the tick.
+void Simulation::split(const Ball& ball) {
+    for (int side = -1; side <= 1; side += 2) {
+        if (static_cast<int>(balls.size() + spawned.size()) >= maxBalls) return;
+        Ball copy = ball;
+        copy.dx = ball.dx + side * 0.5;
+        if (copy.dx > MAX_DX) copy.dx = MAX_DX;
+        if (copy.dx < -MAX_DX) copy.dx = -MAX_DX;
+        spawned.push_back(copy);
+    }
+}
+
+void Simulation::resetBall() {
+    Ball ball;
+    ball.x = paddleX + paddleWidth / 2.0;
+    ball.y = height - 2;
+    balls.resize(1);
+    balls.set(0, ball);
+}
+
+// Returns false once the last life is lost
+bool Simulation::loseLife() {
+    lives--;
+    resetBall();
+    return lives > 0;
+}
+
+static_assert(Simulation::DEFAULT_WIDTH == 9 && Simulation::DEFAULT_HEIGHT == 18,
+              "visitShape() lists the default board's size");
+
+struct Simulation::BallMover {
+    typedef bool result_type;
+    Simulation& sim;
+    
+    template <class Shape> bool operator()(const Shape& shape) const { return sim.moveBalls(shape); }
+};
+
+// The default board and the common endgame sizes have their size compiled
+// in; see visitShape()
+bool Simulation::moveBalls() {
+    BallMover mover = { *this };
+    return visitShape(bricks, mover);
+}
+
+// Moves every free ball in order. A ball that drops out is removed; a life
+// is lost only when none are left. Returns false once the last life is lost.
+template <class Shape>
+bool Simulation::moveBalls(const Shape& shape) {
+    // Balls with only walls and the bottom in reach are moved together by
+    // the vector kernel. They can't touch anything the others change, so
+    // doing them first keeps the order deterministic.
+    ballCells.clear();
+    for (size_t i = 0; i < balls.size(); i++) {
+        Ball ball = balls.get(i);
+        ballCells.push_back(getBallCell(ball));
+        if (inFreeFlight(shape, ball)) balls.flags[i] |= BallStore::FREE;
+    }
+    if (fixedPoint) {
+        balls.integrateFixed(Fixed::fromDouble(ballStep), shape.height());
+    } else {
+        balls.integrateFree(ballStep, shape.width(), shape.height(), kernel);
+    }
+    
+    for (size_t i = 0; i < balls.size(); i++) {
+        if (balls.flags[i] & BallStore::FREE) continue;
+        Ball ball = balls.get(i);
+        bool checkBricks = nearBricks(shape, ball);
+        bool inPlay = fixedPoint ? moveBallFixed(shape, ball, checkBricks)
+                                 : moveBall(shape, ball, checkBricks);
+        balls.set(i, ball);
+        if (!inPlay) balls.flags[i] |= BallStore::LOST;
+    }
+    
+    size_t kept = 0;
+    for (size_t i = 0; i < balls.size(); i++) {
+        if (balls.flags[i] & BallStore::LOST) {
+            dirty.push_back(ballCells[i]);
+            continue;
+        }
+        Ball ball = balls.get(i);
+        markBall(ballCells[i], getBallCell(ball));
+        balls.set(kept++, ball);
+    }
+    balls.resize(kept);
+    
+    for (size_t i = 0; i < spawned.size(); i++) {
+        balls.push(spawned[i]);
+        dirty.push_back(getBallCell(spawned[i]));
+    }
+    spawned.clear();
+    
+    if (balls.empty()) {
+        return loseLife();
+    }
+    return true;
+}
+
+// Sweeps the ball along this tick's path one grid line at a time and
+// resolves every wall, paddle and brick contact in the order it happens.
+// The side walls sit at x = 0 and x = width, the top at y = 0, the paddle
+// line at y = height - 2 and the ball is lost at y = height.
+// Brick checks can be skipped when checkBricks is false.
+// Returns false if the ball dropped out of the bottom.
+template <class Shape>
+bool Simulation::moveBall(const Shape& shape, Ball& ball, bool checkBricks) {
+    double remaining = 1.0;
+    int cx = cellIndex(ball.x, ball.dx);
+    int cy = cellIndex(ball.y, ball.dy);
+    
+    for (int contacts = 0; contacts < MAX_CONTACTS; ) {
+        double vx = ball.dx * ballStep;
+        double vy = ball.dy * ballStep;
+        int lineX = (vx > 0) ? cx + 1 : cx;
+        int lineY = (vy > 0) ? cy + 1 : cy;
+        double tx = (vx != 0) ? (lineX - ball.x) / vx : NEVER;
+        double ty = (vy != 0) ? (lineY - ball.y) / vy : NEVER;
+        double t = (tx < ty) ? tx : ty;
+        
+        if (t > remaining) {
+            ball.x += vx * remaining;
+            ball.y += vy * remaining;
+            return true;
+        }
+        
+        bool crossX = (tx == t);
+        bool crossY = (ty == t);
+        ball.x = crossX ? lineX : ball.x + vx * t;
+        ball.y = crossY ? lineY : ball.y + vy * t;
+        remaining -= t;
+        
+        int nx = cx + sign(vx);
+        int ny = cy + sign(vy);
+        bool bounceX = crossX && (lineX <= 0 || lineX >= shape.width());
+        bool bounceY = crossY && vy < 0 && lineY <= 0;
+        bool paddleHit = false;
+        
+        if (crossY && vy > 0) {
+            if (lineY >= shape.height()) {
+                return false;
+            }
+            paddleHit = (lineY == shape.height() - 2 &&
+                         ball.x >= paddleX && ball.x <= paddleX + paddleWidth);
+        }
+        
+        // Bricks beside the ball first, the diagonal one only when the
+        // ball passes exactly through a corner between empty cells
+        int splits = 0;
+        if (checkBricks) {
+            if (crossX && !bounceX && shape.brickAt(nx, cy)) {
+                splits += hitBrick(nx, cy);
+                bounceX = true;
+            }
+            if (crossY && !bounceY && !paddleHit && shape.brickAt(cx, ny)) {
+                splits += hitBrick(cx, ny);
+                bounceY = true;
+            }
+            if (crossX && crossY && !bounceX && !bounceY && !paddleHit && shape.brickAt(nx, ny)) {
+                splits += hitBrick(nx, ny);
+                bounceX = bounceY = true;
+            }
+        }
+        
+        if (bounceX) {
+            ball.dx = -ball.dx;
+        } else if (crossX) {
+            cx = nx;
+        }
+        
+        if (paddleHit) {
+            double hitPos = (ball.x - paddleX) / paddleWidth;
+            double dx = (hitPos - 0.5) * 2.0; // -1 to 1
+            ball.dx = dx * MAX_DX;
+            ball.dy = -std::fabs(ball.dy);
+            cx = cellIndex(ball.x, ball.dx);
+        } else if (bounceY) {
+            ball.dy = -ball.dy;
+        } else if (crossY) {
+            cy = ny;
+        }
+        
+        for (; splits > 0; splits--) {
+            split(ball);
+        }
+        if (bounceX || bounceY || paddleHit) contacts++;
+    }
+    return true;
+}
+
+// moveBall() in 16.16 fixed point, with the same contacts in the same order.
+// Each straight stretch between bounces is followed from where it started:
+// crossing times are compared as exact integer ratios, and positions are
+// worked out from the start of the stretch, so passing grid lines leaves no
+// rounding behind. A ball that bounces off nothing moves by exactly one
+// tick's velocity, as BallStore::integrateFixed() moves it.
+template <class Shape>
+bool Simulation::moveBallFixed(const Shape& shape, Ball& ball, bool checkBricks) {
+    const int64_t one = Fixed::ONE;
+    const int64_t step = Fixed::fromDouble(ballStep);
+    int64_t x = Fixed::fromDouble(ball.x);     // start of the stretch
+    int64_t y = Fixed::fromDouble(ball.y);
+    int64_t dx = Fixed::fromDouble(ball.dx);
+    int64_t dy = Fixed::fromDouble(ball.dy);
+    int64_t remaining = one;                   // of the tick, from (x, y)
+    int cx = fixedCell(x, dx);
+    int cy = fixedCell(y, dy);
+    
+    for (int contacts = 0; contacts < MAX_CONTACTS; ) {
+        int64_t vx = Fixed::mul(dx, step);
+        int64_t vy = Fixed::mul(dy, step);
+        int lineX = (vx > 0) ? cx + 1 : cx;
+        int lineY = (vy > 0) ? cy + 1 : cy;
+        // A line is reached in time distance / |v|; compared by cross-multiplying
+        int64_t distX = absolute(lineX * one - x);
+        int64_t distY = absolute(lineY * one - y);
+        bool reachX = vx != 0 && distX * one <= remaining * absolute(vx);
+        bool reachY = vy != 0 && distY * one <= remaining * absolute(vy);
+        
+        if (!reachX && !reachY) {
+            ball.x = Fixed::toDouble(x + Fixed::mul(vx, remaining));
+            ball.y = Fixed::toDouble(y + Fixed::mul(vy, remaining));
+            ball.dx = Fixed::toDouble(dx);
+            ball.dy = Fixed::toDouble(dy);
+            return true;
+        }
+        
+        bool crossX = reachX && (!reachY || distX * absolute(vy) <= distY * absolute(vx));
+        bool crossY = reachY && (!reachX || distY * absolute(vx) <= distX * absolute(vy));
+        // Where the ball is when it gets to the line
+        int64_t atX = crossX ? lineX * one : x + vx * distY / absolute(vy);
+        int64_t atY = crossY ? lineY * one : y + vy * distX / absolute(vx);
+        
+        int nx = cx + (vx > 0) - (vx < 0);
+        int ny = cy + (vy > 0) - (vy < 0);
+        bool bounceX = crossX && (lineX <= 0 || lineX >= shape.width());
+        bool bounceY = crossY && vy < 0 && lineY <= 0;
+        bool paddleHit = false;
+        
+        if (crossY && vy > 0) {
+            if (lineY >= shape.height()) {
+                return false;
+            }
+            paddleHit = (lineY == shape.height() - 2 &&
+                         atX >= paddleX * one && atX <= (paddleX + paddleWidth) * one);
+        }
+        
+        int splits = 0;
+        if (checkBricks) {
+            if (crossX && !bounceX && shape.brickAt(nx, cy)) {
+                splits += hitBrick(nx, cy);
+                bounceX = true;
+            }
+            if (crossY && !bounceY && !paddleHit && shape.brickAt(cx, ny)) {
+                splits += hitBrick(cx, ny);
+                bounceY = true;
+            }
+            if (crossX && crossY && !bounceX && !bounceY && !paddleHit && shape.brickAt(nx, ny)) {
+                splits += hitBrick(nx, ny);
+                bounceX = bounceY = true;
+            }
+        }
+        
+        if (bounceX) {
+            dx = -dx;
+        } else if (crossX) {
+            cx = nx;
+        }
+        
+        if (paddleHit) {
+            // (hitPos - 0.5) * 2 * MAX_DX with hitPos = (x - paddleX) / paddleWidth
+            int64_t paddle = paddleWidth * one;
+            dx = (2 * (atX - paddleX * one) - paddle) * Fixed::fromDouble(MAX_DX) / paddle;
+            dy = -absolute(dy);
+            cx = fixedCell(atX, dx);
+        } else if (bounceY) {
+            dy = -dy;
+        } else if (crossY) {
+            cy = ny;
+        }
+        
+        if (bounceX || bounceY || paddleHit) {
+            // A new stretch starts at the contact
+            remaining -= (crossX ? distX * one / absolute(vx) : distY * one / absolute(vy));
+            x = atX;
+            y = atY;
+            ball.x = Fixed::toDouble(x);
+            ball.y = Fixed::toDouble(y);
+            ball.dx = Fixed::toDouble(dx);
+            ball.dy = Fixed::toDouble(dy);
+            contacts++;
+        }
+        for (; splits > 0; splits--) {
+            split(ball);
+        }
+    }
+    return true;
+}
+
+// Broad phase: bounces only fold the path back on itself, so a ball stays
+// within one tick's travel of where it starts (a paddle return can speed it
+// up sideways to MAX_DX). True if that box holds any brick.
+template <class Shape>
+bool Simulation::nearBricks(const Shape& shape, const Ball& ball) const {
+    double reachX = ballStep * std::max(std::fabs(ball.dx), MAX_DX) + 1;
+    double reachY = ballStep * std::fabs(ball.dy) + 1;
+    return shape.anyInRect(static_cast<int>(std::floor(ball.x - reachX)),
+                           static_cast<int>(std::floor(ball.y - reachY)),
+                           static_cast<int>(std::floor(ball.x + reachX)),
+                           static_cast<int>(std::floor(ball.y + reachY)));
+}
+
+// True if the ball can reach neither a brick nor the paddle line this tick,
+// with a cell of margin so rounding never decides a paddle hit. The
+// fixed-point kernel doesn't bounce, so there the walls count too.
+template <class Shape>
+bool Simulation::inFreeFlight(const Shape& shape, const Ball& ball) const {
+    double nextY = ball.y + ball.dy * ballStep;
+    if (ball.dy > 0 && ball.y < shape.height() - 2 && nextY + 1 >= shape.height() - 2) return false;
+    if (fixedPoint) {
+        double nextX = ball.x + ball.dx * ballStep;
+        if (nextX <= 1 || nextX >= shape.width() - 1 || (ball.dy < 0 && nextY <= 1)) return false;
+    }
+    return !nearBricks(shape, ball);
+}
+
+// Time in ticks until the ball next reaches something it could bounce off or
+// be lost at, or limit if that is further away. Does not change any state.
+double Simulation::timeToContact(const Ball& ball, double limit) const {
+    double x = ball.x;
+    double y = ball.y;
+    double vx = ball.dx * ballStep;
+    double vy = ball.dy * ballStep;
+    int cx = cellIndex(x, vx);
+    int cy = cellIndex(y, vy);
+    double elapsed = 0;
+    
+    while (elapsed < limit) {
+        int lineX = (vx > 0) ? cx + 1 : cx;
+        int lineY = (vy > 0) ? cy + 1 : cy;
+        double tx = (vx != 0) ? (lineX - x) / vx : NEVER;
+        double ty = (vy != 0) ? (lineY - y) / vy : NEVER;
+        double t = (tx < ty) ? tx : ty;
+        if (t == NEVER) return limit;
+        
+        elapsed += t;
+        bool crossX = (tx == t);
+        bool crossY = (ty == t);
+        int nx = cx + sign(vx);
+        int ny = cy + sign(vy);
+        
+        if (crossX && (lineX <= 0 || lineX >= width || brickAt(nx, cy))) break;
+        if (crossY && ((vy < 0 && lineY <= 0) || (vy > 0 && lineY >= height - 2) ||
+                       brickAt(cx, ny))) break;
+        if (crossX && crossY && brickAt(nx, ny)) break;
+        
+        x = crossX ? lineX : x + vx * t;
+        y = crossY ? lineY : y + vy * t;
+        if (crossX) cx = nx;
+        if (crossY) cy = ny;
+    }
+    return (elapsed < limit) ? elapsed : limit;
+}
+
+StepEvent Simulation::nextLevel() {
+    level++;
+    if (level > LEVEL_COUNT) {
+        return StepEvent::GAME_WON;
+    }
+    loadLevel();
+    return StepEvent::LEVEL_COMPLETE;
+}
+
+void Simulation::countLiveBricks() {
+    int count = 0;
+    bricks.forEachBrick([&count](int, int, Brick brick) {
+        if (brick.breakable()) count++;
+    });
+    liveBricks = count;
+}
+
+void Simulation::loadLevel() {
+    boardReset = true;
+    
+    if (hasEndGame && level == endgameLevel) {
+        bricks = endgameBoard;
+    } else {
+        loadBuiltinLevel();
+    }
+    countLiveBricks();
+    resetBall();
+}
+
+// Restarts and replays of a level copy its cached board in one go
+void Simulation::loadBuiltinLevel() {
+    prepareLevels();
+    bricks = levelBoards[levelIndex(level)];
+}
+
+// Stamps the layouts that aren't built at the current board size yet
+void Simulation::prepareLevels() {
+    for (int i = 0; i < LEVEL_COUNT; i++) {
+        BrickGrid& board = levelBoards[i];
+        if (board.getWidth() != width || board.getHeight() != height) {
+            board.resize(width, height);
+            stampLevel(LEVELS[i], board);
+        }
+    }
+}
\ No newline at end of file
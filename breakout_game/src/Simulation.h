@@ -0,0 +1,148 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "BallStore.h"
+#include "BrickGrid.h"
+#include "EndGame.h"
+#include "Levels.h"
+#include "Rng.h"
+#include <vector>
+
+// One tick worth of player input
+struct Input {
+    int move;       // paddle cells to move, negative = left
+    bool launch;
+    bool restart;
+    
+    Input() : move(0), launch(false), restart(false) {}
+};
+
+// What happened during a step, for the shell to react to
+enum class StepEvent {
+    NONE,
+    LEVEL_COMPLETE,
+    GAME_WON,
+    GAME_OVER
+};
+
+// Game rules without any terminal I/O or timing. One call to step() is one tick.
+class Simulation {
+private:
+    int width, height;
+    int paddleX, paddleWidth;
+    BallStore balls;            // never empty; moved in this order every tick
+    std::vector<Ball> spawned;  // split off during the current tick
+    std::vector<Cell> ballCells;    // where each ball was drawn before the tick
+    BallKernel kernel;
+    bool fixedPoint;            // 16.16 integer physics, see setFixedPoint()
+    double ballStep;            // distance covered per tick at unit velocity
+    double powerUpChance;       // chance a destroyed brick splits the ball
+    int maxBalls;
+    BrickGrid bricks;
+    int liveBricks;             // breakable bricks left on the board
+    int score;
+    int lives;
+    int level;
+    long tick;                  // steps since reset()
+    Rng rng;
+    
+    // Endgame board replayed instead of the built-in layout on its level
+    BrickGrid endgameBoard;
+    bool hasEndGame;
+    int endgameLevel;
+    // Built-in layouts stamped at the current board size, built on first use
+    BrickGrid levelBoards[LEVEL_COUNT];
+    
+    // Changes made by the last step
+    std::vector<Cell> dirty;
+    bool boardReset;
+    
+public:
+    // Default cap on balls in play for multi-ball games
+    static const int MAX_BALLS = 256;
+    // Board played when no endgame says otherwise; its collision code is
+    // built for exactly this size
+    static const int DEFAULT_WIDTH = 9;
+    static const int DEFAULT_HEIGHT = 18;
+    
+    Simulation(int width, int height);
+    
+    void resize(int w, int h);
+    void setBallStep(double cellsPerTick);
+    // Deterministic mode: ball positions, velocities and the ball step are
+    // kept on the 16.16 fixed-point grid and moved with integer arithmetic
+    // only, so a game plays out bit for bit the same on every build. The
+    // two modes don't give the same games.
+    void setFixedPoint(bool on);
+    // Multi-ball: each destroyed brick splits the ball that broke it into
+    // three with the given chance, up to limit balls in play
+    // Also reserves room for limit balls, so play never grows the ball arrays
+    void setPowerUps(double chance, int limit);
+    void seed(uint64_t value) { rng.seed(value); }
+    // All kernels give the same results; this only exists for benchmarks
+    void setBallKernel(BallKernel k) { kernel = k; }
+    void reset(int startLevel);
+    void loadEndGame(const EndGame& endgame);
+    void loadLevel();
+    StepEvent step(const Input& input);
+    // Spectators: takes on a state published by a game running elsewhere,
+    // without applying any rules. The board counts as replaced.
+    void mirror(const BrickGrid& board, const BallStore& state, int paddle, int newScore,
+                int newLives, int newLevel, long ticks);
+    
+    // Moves the free balls through as many whole ticks as possible without
+    // any reaching a wall, brick, the paddle line or the bottom, up to maxTicks.
+    // Equivalent to that many step(Input()) calls, up to floating-point
+    // rounding; exactly so in fixed point. Returns the ticks skipped.
+    long fastForward(long maxTicks);
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getPaddleX() const { return paddleX; }
+    int getPaddleWidth() const { return paddleWidth; }
+    // The first ball; the one sitting on the paddle between lives
+    Ball getBall() const { return balls.get(0); }
+    const BallStore& getBalls() const { return balls; }
+    const BrickGrid& getBricks() const { return bricks; }
+    int getScore() const { return score; }
+    int getLives() const { return lives; }
+    int getLevel() const { return level; }
+    int getLiveBricks() const { return liveBricks; }
+    long getTick() const { return tick; }
+    double getBallStep() const { return ballStep; }
+    bool isFixedPoint() const { return fixedPoint; }
+    double getPowerUpChance() const { return powerUpChance; }
+    int getMaxBalls() const { return maxBalls; }
+    // Board cell a ball is drawn in
+    Cell getBallCell(const Ball& ball) const;
+    
+    // Cells whose contents changed during the last step. When isBoardReset()
+    // is true the whole board was replaced and the list is not exhaustive.
+    const std::vector<Cell>& getDirtyCells() const { return dirty; }
+    bool isBoardReset() const { return boardReset; }
+    
+private:
+    void applyInput(const Input& input);
+    bool moveBalls();
+    struct BallMover;
+    // The per-tick collision code, built for each board shape (BoardShape.h)
+    template <class Shape> bool moveBalls(const Shape& shape);
+    template <class Shape> bool nearBricks(const Shape& shape, const Ball& ball) const;
+    template <class Shape> bool inFreeFlight(const Shape& shape, const Ball& ball) const;
+    template <class Shape> bool moveBall(const Shape& shape, Ball& ball, bool checkBricks);
+    template <class Shape> bool moveBallFixed(const Shape& shape, Ball& ball, bool checkBricks);
+    double timeToContact(const Ball& ball, double limit) const;
+    bool brickAt(int x, int y) const;
+    bool hitBrick(int x, int y);
+    void split(const Ball& ball);
+    void resetBall();
+    bool loseLife();
+    StepEvent nextLevel();
+    void loadBuiltinLevel();
+    void prepareLevels();
+    void countLiveBricks();
+    void markPaddle(int oldX);
+    void markBall(const Cell& before, const Cell& after);
+};
+
+#endif
\ No newline at end of file
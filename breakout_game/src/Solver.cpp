@@ -0,0 +1,501 @@
+#include "Solver.h"
+#include "Simulation.h"
+#include "Config.h"
+#include "EndGame.h"
+#include "Fixed.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 2^21 slots of 16 bytes
+const int TABLE_BITS = 21;
+// The solver counts launches itself; the simulation never runs out of lives
+const int LIVES = 1 << 30;
+const uint64_t ATTACHED_KEY = 0xA5A5A5A5A5A5A5A5ULL;
+
+enum class MoveKind {
+    LAUNCH,
+    RETURN,
+    MISS
+};
+
+struct Move {
+    MoveKind kind;
+    long tick;
+    int paddle;     // paddle x
+    int aim;        // launches: -1 left, 0 straight up, 1 right
+};
+
+// Moves leading to a position, newest first; siblings share their past
+struct Trail {
+    Move move;
+    std::shared_ptr<const Trail> previous;
+};
+
+// A position waiting on the player: the ball on the paddle, or about to
+// come down through the paddle line during the next tick
+struct Node {
+    std::shared_ptr<const BrickGrid> board;
+    Ball ball;
+    long ticks;
+    int launches;       // counting the one pending on an attached ball
+    int remaining;      // breakable bricks left
+    int topRow;         // highest row holding a breakable brick
+    std::shared_ptr<const Trail> trail;
+};
+
+uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Hash of the bricks on a board, and the highest row still holding a
+// breakable one
+uint64_t scanBoard(const BrickGrid& board, int& topRow) {
+    uint64_t hash = 0;
+    int top = board.getHeight();
+    const uint64_t width = static_cast<uint64_t>(board.getWidth());
+    board.forEachBrick([&](int x, int y, Brick brick) {
+        hash ^= mix(((static_cast<uint64_t>(y) * width + x) << 8) | brick.bits);
+        if (brick.breakable() && y < top) top = y;
+    });
+    topRow = top;
+    return hash;
+}
+
+// Balls are on the 16.16 grid in fixed point, so their raw values hash exactly
+uint64_t positionKey(uint64_t boardHash, const Ball& ball) {
+    if (ball.attached) return boardHash ^ ATTACHED_KEY;
+    uint64_t key = boardHash;
+    key = mix(key ^ static_cast<uint64_t>(Fixed::fromDouble(ball.x)));
+    key = mix(key ^ static_cast<uint64_t>(Fixed::fromDouble(ball.y)));
+    key = mix(key ^ static_cast<uint64_t>(Fixed::fromDouble(ball.dx)));
+    key = mix(key ^ static_cast<uint64_t>(Fixed::fromDouble(ball.dy)));
+    return key;
+}
+
+// Breakable bricks the ball can never touch. It moves cell to cell across
+// shared edges (a corner is only cut when both cells beside it are clear),
+// so the reachable cells are those joined to the row above the paddle
+// through anything but indestructible bricks.
+int walledIn(const BrickGrid& board, int& exampleX, int& exampleY) {
+    const int width = board.getWidth();
+    const int height = board.getHeight();
+    std::vector<bool> reached(board.area(), false);
+    std::vector<int> open;
+    auto visit = [&](int x, int y) {
+        if (!board.inside(x, y)) return;
+        size_t i = static_cast<size_t>(y) * width + x;
+        if (reached[i] || board.at(x, y).type() == BrickType::INDESTRUCTIBLE) return;
+        reached[i] = true;
+        open.push_back(static_cast<int>(i));
+    };
+    for (int x = 0; x < width; x++) {
+        visit(x, height - 3);
+    }
+    while (!open.empty()) {
+        int i = open.back();
+        open.pop_back();
+        int x = i % width, y = i / width;
+        visit(x - 1, y);
+        visit(x + 1, y);
+        visit(x, y - 1);
+        visit(x, y + 1);
+    }
+    
+    int count = 0;
+    board.forEachBrick([&](int x, int y, Brick brick) {
+        if (!brick.breakable() || reached[static_cast<size_t>(y) * width + x]) return;
+        if (count++ == 0) {
+            exampleX = x;
+            exampleY = y;
+        }
+    });
+    return count;
+}
+
+// Lowest cost each position has been reached at. Slots are written without
+// locks: a slot holds key ^ cost next to the cost, so a read that races a
+// write fails the key check and counts as empty. Colliding positions
+// replace each other, which only costs repeated work.
+class TranspositionTable {
+private:
+    struct Slot {
+        std::atomic<uint64_t> check;
+        std::atomic<int64_t> cost;
+    };
+    
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;
+
+public:
+    explicit TranspositionTable(int bits)
+        : slots(new Slot[static_cast<size_t>(1) << bits]), mask((static_cast<uint64_t>(1) << bits) - 1) {
+        for (uint64_t i = 0; i <= mask; i++) {
+            slots[i].check.store(0, std::memory_order_relaxed);
+            slots[i].cost.store(-1, std::memory_order_relaxed);
+        }
+    }
+    
+    // True if the position was already reached at no more than cost;
+    // otherwise records cost for it
+    bool reached(uint64_t key, int64_t cost) {
+        Slot& slot = slots[key & mask];
+        int64_t seen = slot.cost.load(std::memory_order_relaxed);
+        uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ static_cast<uint64_t>(seen)) == key && seen >= 0 && seen <= cost) return true;
+        slot.cost.store(cost, std::memory_order_relaxed);
+        slot.check.store(key ^ static_cast<uint64_t>(cost), std::memory_order_relaxed);
+        return false;
+    }
+};
+
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Node> nodes;
+};
+
+// Depth-first branch and bound across a pool of workers. Each worker takes
+// its newest position from the back of its own queue and pushes the
+// children there, best last; an idle worker steals the oldest position,
+// the root of the largest unexplored subtree, from the front of another's.
+// A position is dropped once it can't beat the best clear found so far, or
+// was already reached at least as cheaply.
+class Search {
+private:
+    const SolveOptions& opts;
+    int width, height;
+    double ballStep;
+    TranspositionTable table;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::atomic<long> pending;      // positions queued or being expanded
+    std::atomic<long> positions;
+    std::atomic<long> tableHits;
+    std::atomic<long> steals;
+    std::atomic<bool> stopped;
+    
+    std::atomic<int64_t> bestCost;
+    std::mutex bestMutex;
+    long bestTicks;
+    int bestLaunches;
+    std::shared_ptr<const Trail> bestTrail;
+
+public:
+    Search(const SolveOptions& opts, int width, int height, double ballStep)
+        : opts(opts), width(width), height(height), ballStep(ballStep), table(TABLE_BITS),
+          pending(0), positions(0), tableHits(0), steals(0), stopped(false),
+          bestCost(INT64_MAX), bestTicks(0), bestLaunches(0) {}
+    
+    void run(const BrickGrid& board, int threads) {
+        Node root;
+        root.board = std::make_shared<BrickGrid>(board);
+        root.ball.x = (width - 3) / 2 + 1.5;
+        root.ball.y = height - 2;
+        root.ticks = 0;
+        root.launches = 1;
+        root.remaining = 0;
+        board.forEachBrick([&root](int, int, Brick brick) {
+            if (brick.breakable()) root.remaining++;
+        });
+        uint64_t hash = scanBoard(board, root.topRow);
+        table.reached(positionKey(hash, root.ball), cost(root.launches, root.ticks));
+        
+        for (int t = 0; t < threads; t++) {
+            queues.emplace_back(new WorkQueue());
+        }
+        queues[0]->nodes.push_back(root);
+        pending = 1;
+        
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) {
+            pool.emplace_back(&Search::work, this, t);
+        }
+        work(0);
+        for (auto& t : pool) {
+            t.join();
+        }
+    }
+    
+    bool solved() const { return bestTrail != nullptr; }
+    // False when the position budget ran out before the search did
+    bool complete() const { return !stopped; }
+    long getTicks() const { return bestTicks; }
+    int getLaunches() const { return bestLaunches; }
+    long getPositions() const { return positions; }
+    long getTableHits() const { return tableHits; }
+    long getSteals() const { return steals; }
+    
+    std::vector<Move> moves() const {
+        std::vector<Move> list;
+        for (const Trail* t = bestTrail.get(); t; t = t->previous.get()) {
+            list.push_back(t->move);
+        }
+        std::reverse(list.begin(), list.end());
+        return list;
+    }
+
+private:
+    int64_t cost(int launches, long ticks) const {
+        return opts.fewestLaunches ? (static_cast<int64_t>(launches) << 32) + ticks : ticks;
+    }
+    
+    // Ticks the ball needs at least to touch the highest breakable brick;
+    // it always covers exactly ballStep rows a tick
+    long ticksToReach(const Node& node) const {
+        double gap = node.ball.y - (node.topRow + 1);
+        return (gap > 0) ? static_cast<long>(gap / ballStep) : 0;
+    }
+    
+    bool bounded(const Node& node) const {
+        return cost(node.launches, node.ticks + ticksToReach(node)) < bestCost.load();
+    }
+    
+    void work(int id) {
+        Simulation sim(width, height);
+        sim.setFixedPoint(true);
+        sim.setBallStep(ballStep);
+        sim.setPowerUps(0, 1);
+        std::vector<Node> children;
+        Node node;
+        
+        while (!stopped) {
+            if (!take(id, node)) {
+                if (pending == 0) return;
+                std::this_thread::yield();
+                continue;
+            }
+            if (bounded(node)) {
+                if (++positions > opts.maxPositions && opts.maxPositions > 0) {
+                    stopped = true;
+                    return;
+                }
+                expand(sim, node, children);
+                // Fewest bricks left, then earliest, goes on the back
+                std::sort(children.begin(), children.end(), [](const Node& a, const Node& b) {
+                    return a.remaining != b.remaining ? a.remaining > b.remaining : a.ticks > b.ticks;
+                });
+                pending += static_cast<long>(children.size());
+                std::lock_guard<std::mutex> lock(queues[id]->mutex);
+                for (auto& child : children) {
+                    queues[id]->nodes.push_back(std::move(child));
+                }
+            }
+            pending--;
+        }
+    }
+    
+    bool take(int id, Node& node) {
+        {
+            WorkQueue& own = *queues[id];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.nodes.empty()) {
+                node = std::move(own.nodes.back());
+                own.nodes.pop_back();
+                return true;
+            }
+        }
+        int count = static_cast<int>(queues.size());
+        for (int k = 1; k < count; k++) {
+            WorkQueue& victim = *queues[(id + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.nodes.empty()) {
+                node = std::move(victim.nodes.front());
+                victim.nodes.pop_front();
+                steals++;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void expand(Simulation& sim, const Node& node, std::vector<Node>& children) {
+        children.clear();
+        const int paddleWidth = sim.getPaddleWidth();
+        const int last = width - paddleWidth;
+        if (node.ball.attached) {
+            for (int paddle = 0; paddle <= last; paddle++) {
+                for (int aim = -1; aim <= 1; aim++) {
+                    Ball ball;
+                    ball.x = paddle + paddleWidth / 2.0;
+                    ball.y = height - 2;
+                    ball.dx = aim * 0.5;
+                    ball.dy = -1.0;
+                    ball.attached = false;
+                    Move move = { MoveKind::LAUNCH, node.ticks, paddle, aim };
+                    fly(sim, node, ball, move, children);
+                }
+            }
+            return;
+        }
+        
+        // Roughly where the ball comes down; every paddle spot meeting a
+        // cell either side of it is tried
+        double landing = node.ball.x + node.ball.dx * (height - 2 - node.ball.y);
+        if (landing < 0) landing = -landing;
+        if (landing > width) landing = 2.0 * width - landing;
+        int cell = static_cast<int>(std::floor(landing));
+        for (int paddle = std::max(0, cell - paddleWidth - 1); paddle <= std::min(last, cell + 1); paddle++) {
+            Move move = { MoveKind::RETURN, node.ticks, paddle, 0 };
+            fly(sim, node, node.ball, move, children);
+        }
+        // Relaunching can be quicker than any return, never cheaper in launches
+        if (!opts.fewestLaunches) {
+            Move move = { MoveKind::MISS, node.ticks, (landing < width / 2.0) ? last : 0, 0 };
+            fly(sim, node, node.ball, move, children);
+        }
+    }
+    
+    // Plays the move out to the next position needing the player, which
+    // becomes a child unless it is bounded out or already seen
+    void fly(Simulation& sim, const Node& from, const Ball& ball, const Move& move, std::vector<Node>& children) {
+        BallStore state;
+        state.push(ball);
+        // The last level, so clearing the board ends the game instead of
+        // loading another
+        sim.mirror(*from.board, state, move.paddle, 0, LIVES, LEVEL_COUNT, from.ticks);
+        int launches = from.launches;
+        long ticks = from.ticks;
+        
+        for (;;) {
+            StepEvent event = sim.step(Input());
+            ticks++;
+            if (event == StepEvent::GAME_WON || event == StepEvent::LEVEL_COMPLETE) {
+                record(ticks, launches, std::make_shared<Trail>(Trail{ move, from.trail }));
+                return;
+            }
+            Ball next = sim.getBall();
+            if (next.attached) {
+                launches++;
+                break;
+            }
+            if (cost(launches, ticks) >= bestCost.load() || ticks >= opts.maxTicks) return;
+            ticks += sim.fastForward(opts.maxTicks - ticks);
+            next = sim.getBall();
+            if (next.dy > 0 && next.y <= height - 2 && next.y + ballStep >= height - 2) break;
+        }
+        
+        Node child;
+        child.board = std::make_shared<BrickGrid>(sim.getBricks());
+        child.ball = sim.getBall();
+        child.ticks = ticks;
+        child.launches = launches;
+        child.remaining = sim.getLiveBricks();
+        uint64_t hash = scanBoard(*child.board, child.topRow);
+        if (!bounded(child)) return;
+        if (table.reached(positionKey(hash, child.ball), cost(launches, ticks))) {
+            tableHits++;
+            return;
+        }
+        child.trail = std::make_shared<Trail>(Trail{ move, from.trail });
+        children.push_back(std::move(child));
+    }
+    
+    void record(long ticks, int launches, const std::shared_ptr<const Trail>& trail) {
+        std::lock_guard<std::mutex> lock(bestMutex);
+        int64_t c = cost(launches, ticks);
+        if (c >= bestCost.load()) return;
+        bestCost = c;
+        bestTicks = ticks;
+        bestLaunches = launches;
+        bestTrail = trail;
+    }
+};
+
+const char* aimName(int aim) {
+    return (aim < 0) ? "left" : (aim > 0) ? "right" : "straight up";
+}
+
+}
+
+SolveOptions::SolveOptions()
+    : fewestLaunches(false), threads(0), maxTicks(20000), maxPositions(2000000) {}
+
+int runSolver(const SolveOptions& opts) {
+    Config config;
+    if (!opts.config.empty() && !config.loadFromFile(opts.config)) {
+        std::cerr << "Failed to load config: " << opts.config << std::endl;
+        return 1;
+    }
+    EndGame endgame;
+    if (!endgame.loadFromFile(opts.endgame)) {
+        std::cerr << "Failed to load end game: " << opts.endgame << std::endl;
+        return 1;
+    }
+    if (endgame.width < 3 || endgame.height < 3) {
+        std::cerr << "Board too small to play: " << endgame.width << "x" << endgame.height << std::endl;
+        return 1;
+    }
+    
+    int breakable = 0;
+    endgame.bricks.forEachBrick([&breakable](int, int, Brick brick) {
+        if (brick.breakable()) breakable++;
+    });
+    // Searched in fixed point so positions compare exactly
+    double ballStep = Fixed::quantize(static_cast<double>(config.ballSpeed) / config.tickRate);
+    std::cout << "Board:     " << opts.endgame << ", " << endgame.width << "x" << endgame.height
+              << ", " << breakable << " breakable bricks, ball step " << ballStep
+              << " (fixed point)" << std::endl;
+    if (breakable == 0) {
+        std::cout << "Result:    nothing to clear" << std::endl;
+        return 0;
+    }
+    
+    int exampleX = 0, exampleY = 0;
+    int sealed = walledIn(endgame.bricks, exampleX, exampleY);
+    if (sealed > 0) {
+        std::cout << "Result:    impossible, " << sealed << " breakable bricks are walled in by "
+                  << "indestructible ones, e.g. at (" << exampleX << ", " << exampleY << ")" << std::endl;
+        return 2;
+    }
+    
+    int threads = opts.threads;
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    Search search(opts, endgame.width, endgame.height, ballStep);
+    search.run(endgame.bricks, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::cout << "Searched:  " << search.getPositions() << " positions on " << threads << " threads in "
+              << seconds << " s, " << search.getTableHits() << " table hits, "
+              << search.getSteals() << " steals" << std::endl;
+    if (!search.solved()) {
+        std::cout << "Result:    no clear within " << opts.maxTicks << " ticks"
+                  << (search.complete() ? "" : " found before the position limit") << std::endl;
+        return 3;
+    }
+    
+    std::cout << "Result:    cleared in " << search.getTicks() << " ticks with " << search.getLaunches()
+              << (search.getLaunches() == 1 ? " launch" : " launches")
+              << (search.complete() ? ", optimal" : ", best found before the position limit") << std::endl;
+    for (const Move& move : search.moves()) {
+        std::cout << "  tick " << move.tick << ": ";
+        switch (move.kind) {
+            case MoveKind::LAUNCH:
+                std::cout << "launch from x " << move.paddle << ", " << aimName(move.aim);
+                break;
+            case MoveKind::RETURN:
+                std::cout << "return from x " << move.paddle;
+                break;
+            case MoveKind::MISS:
+                std::cout << "let the ball go, paddle at x " << move.paddle;
+                break;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
\ No newline at end of file
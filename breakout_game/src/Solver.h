@@ -0,0 +1,26 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <string>
+
+struct SolveOptions {
+    std::string endgame;    // endgame name
+    bool fewestLaunches;    // rank clears by launches first, then ticks
+    int threads;            // 0 = one per core
+    long maxTicks;          // longest clear looked for
+    long maxPositions;      // search budget, 0 = unlimited
+    std::string config;     // ball speed / tick rate source, empty for defaults
+    
+    SolveOptions();
+};
+
+// Treats an endgame board as a puzzle: finds the quickest way to clear it
+// by choosing where each launch starts and aims, and which part of the
+// paddle meets the ball each time it comes down. The paddle is taken to
+// reach any spot in time. Boards whose breakable bricks are walled in by
+// indestructible ones are reported as impossible without searching.
+// Returns a process exit code: 0 cleared, 2 impossible, 3 no clear found
+// within the limits.
+int runSolver(const SolveOptions& opts);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include "Spectator.h"
+#include "Renderer.h"
+#include "InputThread.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Largest part of the board published, around the first ball. Bigger than
+// any viewport a terminal shows, small enough that a full refill stays cheap.
+const int WINDOW_WIDTH = 256;
+const int WINDOW_HEIGHT = 128;
+const int MAX_BALLS = Simulation::MAX_BALLS;
+
+const char FRAME_MAGIC[4] = { 'B', 'K', 'S', 'P' };
+const uint32_t FRAME_VERSION = 1;
+
+// A publish takes microseconds; past this many overlapping it the reader
+// gives up on the frame, e.g. when the game died mid-publish
+const int MAX_READ_ATTEMPTS = 1000;
+
+enum : uint32_t {
+    IDLE = 0,       // no game in progress
+    LIVE = 1,
+    CLOSED = 2      // the game exited
+};
+
+struct FrameHeader {
+    uint32_t state;
+    uint32_t paused;
+    int32_t width, height;
+    int32_t windowX, windowY;
+    int32_t windowWidth, windowHeight;
+    int32_t paddleX;
+    int32_t score, lives, level;
+    int64_t tick;
+    uint32_t ballCount;
+    uint32_t reserved;
+};
+
+// Everything written under the seqlock. Spectators keep a private copy.
+struct FrameData {
+    FrameHeader header;
+    double ballX[MAX_BALLS], ballY[MAX_BALLS];
+    double ballDx[MAX_BALLS], ballDy[MAX_BALLS];
+    uint8_t ballFlags[MAX_BALLS];
+    uint8_t cells[WINDOW_WIDTH * WINDOW_HEIGHT];   // packed Bricks, windowWidth per row
+};
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the seqlock counter is shared between processes");
+
+std::string segmentName() {
+    return "/breakout-" + std::to_string(getuid());
+}
+
+// Keeps focus at least a quarter of the window away from its edges
+int follow(int start, int size, int focus, int limit) {
+    if (focus < start + size / 4 || focus >= start + size - size / 4) {
+        start = focus - size / 2;
+    }
+    return std::max(0, std::min(start, limit - size));
+}
+
+bool processAlive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+}
+
+// The shared segment. The fields before the data are set once when the game
+// opens it. The count is odd while a publish is under way.
+struct SharedFrame {
+    char magic[4];
+    uint32_t version;
+    int32_t pid;
+    std::atomic<uint32_t> sequence;
+    FrameData data;
+};
+
+namespace {
+
+uint32_t beginWrite(SharedFrame& frame) {
+    uint32_t sequence = frame.sequence.load(std::memory_order_relaxed);
+    sequence += (sequence & 1) ? 1 : 2;     // a crashed game can leave it odd
+    frame.sequence.store(sequence - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return sequence;
+}
+
+void endWrite(SharedFrame& frame, uint32_t sequence) {
+    frame.sequence.store(sequence, std::memory_order_release);
+}
+
+// Copies a consistent frame out of the segment
+bool readFrame(const SharedFrame& frame, FrameData& out) {
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        uint32_t before = frame.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        // Sizes are clamped before use; a torn read is thrown away below
+        std::memcpy(&out.header, &frame.data.header, sizeof(FrameHeader));
+        size_t balls = std::min<uint32_t>(out.header.ballCount, MAX_BALLS);
+        std::memcpy(out.ballX, frame.data.ballX, balls * sizeof(double));
+        std::memcpy(out.ballY, frame.data.ballY, balls * sizeof(double));
+        std::memcpy(out.ballDx, frame.data.ballDx, balls * sizeof(double));
+        std::memcpy(out.ballDy, frame.data.ballDy, balls * sizeof(double));
+        std::memcpy(out.ballFlags, frame.data.ballFlags, balls);
+        size_t cols = std::min(std::max(out.header.windowWidth, 0), WINDOW_WIDTH);
+        size_t rows = std::min(std::max(out.header.windowHeight, 0), WINDOW_HEIGHT);
+        std::memcpy(out.cells, frame.data.cells, cols * rows);
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (frame.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+bool validFrame(const FrameHeader& header) {
+    return header.width > 0 && header.width <= EndGame::MAX_SIZE &&
+           header.height > 0 && header.height <= EndGame::MAX_SIZE &&
+           header.windowWidth > 0 && header.windowWidth <= WINDOW_WIDTH &&
+           header.windowHeight > 0 && header.windowHeight <= WINDOW_HEIGHT &&
+           header.windowX >= 0 && header.windowX + header.windowWidth <= header.width &&
+           header.windowY >= 0 && header.windowY + header.windowHeight <= header.height &&
+           header.ballCount > 0 && header.ballCount <= static_cast<uint32_t>(MAX_BALLS);
+}
+
+// Puts the published window back onto a board the size of the game's
+void rebuild(const FrameData& data, BrickGrid& board, BallStore& balls) {
+    const FrameHeader& header = data.header;
+    if (board.getWidth() != header.width || board.getHeight() != header.height) {
+        board.resize(header.width, header.height);
+    } else {
+        board.clear();
+    }
+    
+    for (int y = 0; y < header.windowHeight; y++) {
+        const uint8_t* row = &data.cells[y * header.windowWidth];
+        for (int x = 0; x < header.windowWidth; x++) {
+            if (!row[x]) continue;
+            int bx = header.windowX + x;
+            int by = header.windowY + y;
+            Brick* chunk = board.addChunk(bx >> BrickGrid::CHUNK_SHIFT, by >> BrickGrid::CHUNK_SHIFT);
+            int offset = ((by & BrickGrid::CHUNK_MASK) << BrickGrid::CHUNK_SHIFT) + (bx & BrickGrid::CHUNK_MASK);
+            chunk[offset].bits = row[x];
+        }
+    }
+    board.reindex();
+    
+    size_t count = header.ballCount;
+    balls.resize(count);
+    std::copy(data.ballX, data.ballX + count, balls.x.begin());
+    std::copy(data.ballY, data.ballY + count, balls.y.begin());
+    std::copy(data.ballDx, data.ballDx + count, balls.dx.begin());
+    std::copy(data.ballDy, data.ballDy + count, balls.dy.begin());
+    std::copy(data.ballFlags, data.ballFlags + count, balls.flags.begin());
+}
+
+}
+
+SpectatorFeed::SpectatorFeed() : frame(nullptr), fd(-1), refill(true) {}
+
+SpectatorFeed::~SpectatorFeed() {
+    close();
+}
+
+bool SpectatorFeed::open() {
+    close();
+    
+    int handle = shm_open(segmentName().c_str(), O_RDWR | O_CREAT, 0600);
+    if (handle < 0) {
+        return false;
+    }
+    // Held until close(); it goes away with the process, so a game that
+    // crashed never keeps the next one from publishing
+    if (flock(handle, LOCK_EX | LOCK_NB) != 0 || ftruncate(handle, sizeof(SharedFrame)) != 0) {
+        ::close(handle);
+        return false;
+    }
+    void* mapped = mmap(nullptr, sizeof(SharedFrame), PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    if (mapped == MAP_FAILED) {
+        ::close(handle);
+        return false;
+    }
+    
+    fd = handle;
+    frame = static_cast<SharedFrame*>(mapped);
+    std::memcpy(frame->magic, FRAME_MAGIC, 4);
+    frame->version = FRAME_VERSION;
+    frame->pid = getpid();
+    refill = true;
+    
+    uint32_t sequence = beginWrite(*frame);
+    std::memset(&frame->data.header, 0, sizeof(FrameHeader));
+    frame->data.header.state = IDLE;
+    endWrite(*frame, sequence);
+    return true;
+}
+
+void SpectatorFeed::close() {
+    if (!frame) return;
+    
+    uint32_t sequence = beginWrite(*frame);
+    frame->data.header.state = CLOSED;
+    endWrite(*frame, sequence);
+    
+    // Attached spectators keep their mapping and see CLOSED
+    shm_unlink(segmentName().c_str());
+    munmap(frame, sizeof(SharedFrame));
+    ::close(fd);
+    frame = nullptr;
+    fd = -1;
+}
+
+void SpectatorFeed::publish(const Simulation& sim, bool paused) {
+    if (!frame) return;
+    
+    uint32_t sequence = beginWrite(*frame);
+    FrameData& data = frame->data;
+    FrameHeader& header = data.header;
+    if (sim.isBoardReset() || header.width != sim.getWidth() || header.height != sim.getHeight()) {
+        refill = true;
+    }
+    header.state = LIVE;
+    header.paused = paused ? 1 : 0;
+    header.width = sim.getWidth();
+    header.height = sim.getHeight();
+    header.paddleX = sim.getPaddleX();
+    header.score = sim.getScore();
+    header.lives = sim.getLives();
+    header.level = sim.getLevel();
+    header.tick = sim.getTick();
+    
+    // The window only changes a few cells a tick; a full copy happens when
+    // it moves or the board is replaced
+    placeWindow(sim);
+    if (refill) {
+        fillWindow(sim);
+        refill = false;
+    } else {
+        const BrickGrid& bricks = sim.getBricks();
+        const std::vector<Cell>& dirty = sim.getDirtyCells();
+        for (size_t i = 0; i < dirty.size(); i++) {
+            int x = dirty[i].x - header.windowX;
+            int y = dirty[i].y - header.windowY;
+            if (x < 0 || x >= header.windowWidth || y < 0 || y >= header.windowHeight) continue;
+            data.cells[y * header.windowWidth + x] = bricks.at(dirty[i].x, dirty[i].y).bits;
+        }
+    }
+    
+    const BallStore& balls = sim.getBalls();
+    size_t count = std::min(balls.size(), static_cast<size_t>(MAX_BALLS));
+    header.ballCount = static_cast<uint32_t>(count);
+    // A plain loop: with the size known to be bounded, memcpy gets inlined
+    // as rep movsb, whose startup cost dwarfs copying a few balls
+    for (size_t i = 0; i < count; i++) {
+        data.ballX[i] = balls.x[i];
+        data.ballY[i] = balls.y[i];
+        data.ballDx[i] = balls.dx[i];
+        data.ballDy[i] = balls.dy[i];
+        data.ballFlags[i] = balls.flags[i];
+    }
+    endWrite(*frame, sequence);
+}
+
+void SpectatorFeed::idle() {
+    if (!frame) return;
+    
+    uint32_t sequence = beginWrite(*frame);
+    frame->data.header.state = IDLE;
+    frame->data.header.paused = 0;
+    endWrite(*frame, sequence);
+}
+
+void SpectatorFeed::placeWindow(const Simulation& sim) {
+    FrameHeader& header = frame->data.header;
+    int w = std::min(sim.getWidth(), WINDOW_WIDTH);
+    int h = std::min(sim.getHeight(), WINDOW_HEIGHT);
+    Cell focus = sim.getBallCell(sim.getBall());
+    int x = follow(header.windowX, w, focus.x, sim.getWidth());
+    int y = follow(header.windowY, h, focus.y, sim.getHeight());
+    if (x != header.windowX || y != header.windowY || w != header.windowWidth || h != header.windowHeight) {
+        header.windowX = x;
+        header.windowY = y;
+        header.windowWidth = w;
+        header.windowHeight = h;
+        refill = true;
+    }
+}
+
+void SpectatorFeed::fillWindow(const Simulation& sim) {
+    FrameHeader& header = frame->data.header;
+    uint8_t* cells = frame->data.cells;
+    const int x0 = header.windowX;
+    const int y0 = header.windowY;
+    const int stride = header.windowWidth;
+    std::memset(cells, 0, static_cast<size_t>(stride) * header.windowHeight);
+    sim.getBricks().forEachBrickIn(x0, y0, x0 + stride - 1, y0 + header.windowHeight - 1,
+                                   [cells, x0, y0, stride](int x, int y, Brick brick) {
+        cells[(y - y0) * stride + (x - x0)] = brick.bits;
+    });
+}
+
+int runSpectator(int fps) {
+    int handle = shm_open(segmentName().c_str(), O_RDONLY, 0);
+    if (handle < 0) {
+        std::cerr << "No game to spectate" << std::endl;
+        return 1;
+    }
+    struct stat info;
+    void* mapped = MAP_FAILED;
+    if (fstat(handle, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(SharedFrame))) {
+        mapped = mmap(nullptr, sizeof(SharedFrame), PROT_READ, MAP_SHARED, handle, 0);
+    }
+    ::close(handle);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "No game to spectate" << std::endl;
+        return 1;
+    }
+    const SharedFrame* shared = static_cast<const SharedFrame*>(mapped);
+    if (std::memcmp(shared->magic, FRAME_MAGIC, 4) != 0 || shared->version != FRAME_VERSION) {
+        std::cerr << "The game publishes an unknown spectator format" << std::endl;
+        munmap(mapped, sizeof(SharedFrame));
+        return 1;
+    }
+    
+    typedef std::chrono::steady_clock Clock;
+    if (fps < 1) fps = 30;
+    if (fps > 240) fps = 240;
+    const Clock::duration frameTime = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / fps));
+    const Clock::duration checkInterval = std::chrono::seconds(1);
+    
+    std::unique_ptr<FrameData> frame(new FrameData());
+    BrickGrid board;
+    BallStore balls;
+    Simulation sim(Simulation::DEFAULT_WIDTH, Simulation::DEFAULT_HEIGHT);
+    Renderer renderer(STDOUT_FILENO);
+    InputThread input;
+    input.start();
+    std::cout << "Waiting for a game, q quits" << std::endl;
+    
+    const char* reason = nullptr;
+    Clock::time_point nextFrame = Clock::now();
+    Clock::time_point nextCheck = nextFrame + checkInterval;
+    while (!reason) {
+        KeyEvent key;
+        while (input.poll(key)) {
+            if (key.key == 'q') reason = "Stopped spectating";
+        }
+        if (reason) break;
+        
+        if (readFrame(*shared, *frame)) {
+            const FrameHeader& header = frame->header;
+            if (header.state == CLOSED) {
+                reason = "The game closed";
+                break;
+            }
+            if (validFrame(header)) {
+                rebuild(*frame, board, balls);
+                sim.mirror(board, balls, header.paddleX, header.score, header.lives, header.level, header.tick);
+                renderer.setOverlay(header.state == IDLE ? "Waiting for the next game" : "Spectating, q quits");
+                renderer.render(sim, header.paused != 0);
+            }
+        }
+        
+        Clock::time_point now = Clock::now();
+        if (now >= nextCheck) {
+            if (!processAlive(shared->pid)) reason = "The game stopped";
+            nextCheck = now + checkInterval;
+        }
+        nextFrame += frameTime;
+        if (nextFrame <= now) nextFrame = now + frameTime;
+        std::this_thread::sleep_until(nextFrame);
+    }
+    
+    input.stop();
+    munmap(mapped, sizeof(SharedFrame));
+    std::cout << reason << std::endl;
+    return 0;
+}
\ No newline at end of file
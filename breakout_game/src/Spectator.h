@@ -0,0 +1,50 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "Simulation.h"
+
+struct SharedFrame;
+
+// Publishes the game being played to spectators through a POSIX shared
+// memory segment. Each publish writes the counters, the balls and a window
+// of the board around the first ball under a seqlock: readers copy the
+// frame and retry if a publish overlapped, so the game never waits on them
+// and pays the same however many are attached. Only the first game to open
+// the segment publishes; later ones run without spectators.
+class SpectatorFeed {
+private:
+    SharedFrame* frame;     // null when not publishing
+    int fd;
+    bool refill;            // window cells must be rebuilt from the board
+
+public:
+    SpectatorFeed();
+    ~SpectatorFeed();
+    
+    SpectatorFeed(const SpectatorFeed&) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed&) = delete;
+    
+    // Returns false if shared memory isn't available or another game
+    // already publishes
+    bool open();
+    // Tells spectators the game closed and removes the segment
+    void close();
+    bool isOpen() const { return frame != nullptr; }
+    
+    // Call after every Simulation::step, and once per frame while paused
+    void publish(const Simulation& sim, bool paused);
+    // The board was replaced outside step(), e.g. a new game started
+    void invalidate() { refill = true; }
+    // No game in progress; spectators keep the last frame and wait
+    void idle();
+
+private:
+    void placeWindow(const Simulation& sim);
+    void fillWindow(const Simulation& sim);
+};
+
+// breakout --spectate: shows the game published by another process at fps
+// frames per second, until it closes or q is pressed
+int runSpectator(int fps);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "TrajectoryPredictor.h"
+#include "BoardShape.h"
+#include "Fixed.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double NEVER = std::numeric_limits<double>::infinity();
+
+// How far the simulation may drift from a cached path, in cells and cells
+// per tick, before the path is traced again
+const double TOLERANCE = 1e-6;
+// Fixed-point play rounds the position at every bounce, which the path,
+// traced in floating point, doesn't; this allows for a few hundred
+const double FIXED_TOLERANCE = 1.0 / 256;
+
+// Grid lines crossed per prediction inside bands holding bricks
+const int MAX_STEPS = 1 << 16;
+
+// Same as Simulation's: the cell the ball is in, taking its direction into
+// account when it sits exactly on a cell boundary
+int cellIndex(double pos, double velocity) {
+    double cell = std::floor(pos);
+    if (velocity < 0 && cell == pos) cell -= 1;
+    return static_cast<int>(cell);
+}
+
+int sign(double v) {
+    return (v > 0) - (v < 0);
+}
+
+// Reflects an unfolded x back between the walls at 0 and width; mirrored
+// is set when that reverses the direction of travel
+double fold(double x, int width, bool& mirrored) {
+    double period = 2.0 * width;
+    double m = std::fmod(x, period);
+    if (m < 0) m += period;
+    mirrored = (m > width);
+    return mirrored ? period - m : m;
+}
+
+// Distance covered per tick at velocity v, rounded the way the simulation
+// rounds it
+double tickVelocity(const Simulation& sim, double v) {
+    if (!sim.isFixedPoint()) return v * sim.getBallStep();
+    return Fixed::toDouble(Fixed::mul(Fixed::fromDouble(v), Fixed::fromDouble(sim.getBallStep())));
+}
+
+}
+
+const int TrajectoryPredictor::CACHE_SIZE;
+const int TrajectoryPredictor::MAX_LEGS;
+
+TrajectoryPredictor::TrajectoryPredictor() : uses(0), lastTick(0) {
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        entries[i].used = false;
+        entries[i].legs.reserve(MAX_LEGS);
+        entries[i].contacts.reserve(2 * MAX_LEGS);
+    }
+}
+
+void TrajectoryPredictor::clear() {
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        entries[i].used = false;
+    }
+}
+
+bool TrajectoryPredictor::predict(const Simulation& sim, const Ball& ball, double& landingX, double& ticks) {
+    // The tick count only goes back when a game restarts on a fresh board
+    if (sim.getTick() < lastTick) clear();
+    lastTick = sim.getTick();
+    uses++;
+    
+    Entry* slot = &entries[0];
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        Entry& entry = entries[i];
+        if (follows(entry, sim, ball)) {
+            if (unchanged(entry, sim, static_cast<double>(sim.getTick() - entry.tick))) {
+                entry.lastUse = uses;
+                landingX = entry.landingX;
+                ticks = entry.arrival - (sim.getTick() - entry.tick);
+                return entry.lands;
+            }
+            entry.used = false;
+        }
+        if (!entry.used) {
+            slot = &entry;
+        } else if (slot->used && entry.lastUse < slot->lastUse) {
+            slot = &entry;
+        }
+    }
+    
+    slot->lands = trace(*slot, sim, ball);
+    slot->used = !slot->legs.empty();
+    slot->tick = sim.getTick();
+    slot->lastUse = uses;
+    slot->width = sim.getWidth();
+    slot->height = sim.getHeight();
+    landingX = slot->landingX;
+    ticks = slot->arrival;
+    return slot->lands;
+}
+
+// True if the ball is where the path puts it at this tick, moving the same way
+bool TrajectoryPredictor::follows(const Entry& entry, const Simulation& sim, const Ball& ball) const {
+    if (!entry.used || entry.width != sim.getWidth() || entry.height != sim.getHeight()) return false;
+    double dt = static_cast<double>(sim.getTick() - entry.tick);
+    if (dt < 0 || dt > entry.arrival) return false;
+    
+    std::vector<Leg>::const_iterator next = std::upper_bound(
+        entry.legs.begin(), entry.legs.end(), dt, [](double t, const Leg& leg) { return t < leg.t0; });
+    const Leg& leg = *(next - 1);
+    bool mirrored;
+    double x = fold(leg.x + leg.vx * (dt - leg.t0), entry.width, mirrored);
+    double y = leg.y + leg.vy * (dt - leg.t0);
+    double vx = mirrored ? -leg.vx : leg.vx;
+    double tolerance = sim.isFixedPoint() ? FIXED_TOLERANCE : TOLERANCE;
+    return std::fabs(x - ball.x) < tolerance && std::fabs(y - ball.y) < tolerance &&
+           std::fabs(vx - tickVelocity(sim, ball.dx)) < TOLERANCE &&
+           std::fabs(leg.vy - tickVelocity(sim, ball.dy)) < TOLERANCE;
+}
+
+// True while every brick the path has yet to bounce off, dt ticks in, is
+// as the path expects. Only the first contact still ahead is compared for
+// each brick; later ones follow from it.
+bool TrajectoryPredictor::unchanged(const Entry& entry, const Simulation& sim, double dt) const {
+    const BrickGrid& bricks = sim.getBricks();
+    for (size_t i = 0; i < entry.contacts.size(); i++) {
+        const Contact& contact = entry.contacts[i];
+        if (contact.t <= dt) continue;
+        if (contact.previous >= 0 && entry.contacts[contact.previous].t > dt) continue;
+        if (bricks.at(contact.x, contact.y).bits != contact.bits) return false;
+    }
+    return true;
+}
+
+bool TrajectoryPredictor::contact(Entry& entry, const BrickGrid& bricks, int x, int y, double t) {
+    int previous = -1;
+    Brick brick = bricks.at(x, y);
+    for (size_t i = entry.contacts.size(); i-- > 0;) {
+        const Contact& earlier = entry.contacts[i];
+        if (earlier.x == x && earlier.y == y) {
+            previous = static_cast<int>(i);
+            brick.bits = earlier.bits;
+            brick.hit();
+            break;
+        }
+    }
+    if (brick.empty()) return false;
+    
+    Contact added = { t, x, y, previous, brick.bits };
+    entry.contacts.push_back(added);
+    return true;
+}
+
+struct TrajectoryPredictor::Tracer {
+    typedef bool result_type;
+    const TrajectoryPredictor& predictor;
+    Entry& entry;
+    const Simulation& sim;
+    const Ball& ball;
+    
+    template <class Shape> bool operator()(const Shape& shape) const {
+        return predictor.trace(entry, sim, shape, ball);
+    }
+};
+
+// Brick lookups go through the same board shapes as Simulation::moveBalls()
+bool TrajectoryPredictor::trace(Entry& entry, const Simulation& sim, const Ball& ball) const {
+    Tracer tracer = { *this, entry, sim, ball };
+    return visitShape(sim.getBricks(), tracer);
+}
+
+template <class Shape>
+bool TrajectoryPredictor::trace(Entry& entry, const Simulation& sim, const Shape& shape, const Ball& ball) const {
+    const int width = shape.width();
+    const int paddleLine = shape.height() - 2;
+    const BrickGrid& bricks = sim.getBricks();
+    double x = ball.x;
+    double y = ball.y;
+    double vx = tickVelocity(sim, ball.dx);
+    double vy = tickVelocity(sim, ball.dy);
+    entry.legs.clear();
+    entry.contacts.clear();
+    entry.landingX = x;
+    entry.arrival = 0;
+    if (vy == 0 || (vy > 0 && y >= paddleLine)) return false;
+    
+    double t = 0;
+    Leg first = { t, x, y, vx, vy };
+    entry.legs.push_back(first);
+    int cx = cellIndex(x, vx);
+    int cy = cellIndex(y, vy);
+    // Row where the band ahead was last found to hold bricks; no need to
+    // look again until the ball leaves it or turns round
+    int blockedRow = -1;
+    
+    for (int steps = 0; steps < MAX_STEPS; steps++, entry.arrival = t) {
+        // Try to cross the rest of this chunk row in one go: if no brick is
+        // within a cell of the straight-line path, only the side walls can
+        // turn the ball, and those fold in analytically
+        if (cy != blockedRow) {
+            int stop = (vy > 0)
+                ? std::min(paddleLine, ((cy >> BrickGrid::CHUNK_SHIFT) + 1) << BrickGrid::CHUNK_SHIFT)
+                : std::max(0, (cy >> BrickGrid::CHUNK_SHIFT) << BrickGrid::CHUNK_SHIFT);
+            double span = (stop - y) / vy;
+            double endX = x + vx * span;
+            int firstCol = 0;
+            int lastCol = width - 1;
+            if (endX >= 0 && endX <= width) {
+                firstCol = static_cast<int>(std::floor(std::min(x, endX))) - 1;
+                lastCol = static_cast<int>(std::floor(std::max(x, endX))) + 1;
+            }
+            // Includes the row entered at the stop line
+            int firstRow = (vy > 0) ? cy : stop - 1;
+            int lastRow = (vy > 0) ? stop : cy;
+            if (!shape.anyInRect(firstCol, firstRow, lastCol, lastRow)) {
+                bool mirrored;
+                x = fold(endX, width, mirrored);
+                if (mirrored) vx = -vx;
+                if ((x >= width && vx > 0) || (x <= 0 && vx < 0)) vx = -vx;
+                y = stop;
+                t += span;
+                if (vy > 0 && stop == paddleLine) {
+                    entry.landingX = x;
+                    entry.arrival = t;
+                    return true;
+                }
+                if (vy < 0 && stop == 0) {
+                    vy = -vy;
+                    if (entry.legs.size() >= static_cast<size_t>(MAX_LEGS)) return false;
+                    Leg leg = { t, x, y, vx, vy };
+                    entry.legs.push_back(leg);
+                }
+                cx = cellIndex(x, vx);
+                cy = cellIndex(y, vy);
+                continue;
+            }
+            blockedRow = cy;
+        }
+        
+        // Bricks nearby: cross one grid line the way Simulation::moveBall does
+        int lineX = (vx > 0) ? cx + 1 : cx;
+        int lineY = (vy > 0) ? cy + 1 : cy;
+        double tx = (vx != 0) ? (lineX - x) / vx : NEVER;
+        double ty = (lineY - y) / vy;
+        double dt = (tx < ty) ? tx : ty;
+        bool crossX = (tx == dt);
+        bool crossY = (ty == dt);
+        x = crossX ? lineX : x + vx * dt;
+        y = crossY ? lineY : y + vy * dt;
+        t += dt;
+        
+        if (crossY && vy > 0 && lineY == paddleLine) {
+            entry.landingX = x;
+            entry.arrival = t;
+            return true;
+        }
+        
+        int nx = cx + sign(vx);
+        int ny = cy + sign(vy);
+        bool bounceX = crossX && (lineX <= 0 || lineX >= width);
+        bool bounceY = crossY && vy < 0 && lineY <= 0;
+        if (crossX && !bounceX && shape.brickAt(nx, cy) && contact(entry, bricks, nx, cy, t)) {
+            bounceX = true;
+        }
+        if (crossY && !bounceY && shape.brickAt(cx, ny) && contact(entry, bricks, cx, ny, t)) {
+            bounceY = true;
+        }
+        if (crossX && crossY && !bounceX && !bounceY && shape.brickAt(nx, ny) &&
+            contact(entry, bricks, nx, ny, t)) {
+            bounceX = bounceY = true;
+        }
+        
+        if (bounceX) {
+            vx = -vx;
+        } else if (crossX) {
+            cx = nx;
+        }
+        if (bounceY) {
+            vy = -vy;
+            blockedRow = -1;
+        } else if (crossY) {
+            cy = ny;
+        }
+        if (bounceX || bounceY) {
+            // Each leg starts with at most two contacts, so neither list
+            // outgrows what the constructor reserved
+            if (entry.legs.size() >= static_cast<size_t>(MAX_LEGS)) return false;
+            Leg leg = { t, x, y, vx, vy };
+            entry.legs.push_back(leg);
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef TRAJECTORYPREDICTOR_H
+#define TRAJECTORYPREDICTOR_H
+
+#include "Simulation.h"
+#include <cstdint>
+#include <vector>
+
+// Works out where a ball next comes down through the paddle line
+// (y = height - 2), following the same contact rules as Simulation::moveBall.
+// Stretches of the board with no bricks are crossed in one step, with the
+// side walls folded in analytically; only bands holding bricks are walked
+// cell by cell.
+//
+// Predictions are cached with the path they took. A later call for a ball
+// that is still on a cached path reuses it, until a brick the path has yet
+// to bounce off is no longer as the path expects; bounces already made
+// wear their bricks down as predicted and don't count. Bricks only ever
+// appear when a board is loaded, which always puts the ball back on the
+// paddle, so an attached ball clears the cache. Paths that never reach the
+// paddle, e.g. a ball trapped between indestructible bricks, are cached the
+// same way.
+class TrajectoryPredictor {
+public:
+    static const int CACHE_SIZE = 4;
+    // Bounces followed per prediction; a ball wedged between bricks for
+    // longer is not predicted
+    static const int MAX_LEGS = 256;
+
+private:
+    // Straight stretch of the path from time t0. x is unfolded: positions
+    // along it are reflected back between the side walls.
+    struct Leg {
+        double t0;
+        double x, y;
+        double vx, vy;
+    };
+    
+    struct Contact {
+        double t;       // when the ball meets the brick
+        int x, y;
+        int previous;   // earlier contact with the same brick, or -1
+        uint8_t bits;   // the brick as the ball finds it: as traced, less
+                        // the hits earlier along the path
+    };
+    
+    struct Entry {
+        bool used;
+        bool lands;         // false when the trace gave up before the paddle line
+        long tick;          // simulation tick the path starts at
+        long lastUse;
+        int width, height;
+        double landingX;
+        double arrival;     // ticks from the start to the paddle line, or traced
+        std::vector<Leg> legs;
+        std::vector<Contact> contacts;
+    };
+    
+    Entry entries[CACHE_SIZE];
+    long uses;
+    long lastTick;
+
+public:
+    TrajectoryPredictor();
+    
+    // x where the ball next crosses the paddle line going down, and how
+    // many ticks from now. False if it doesn't get there within MAX_LEGS
+    // bounces, or is already below the line.
+    bool predict(const Simulation& sim, const Ball& ball, double& landingX, double& ticks);
+    void clear();
+
+private:
+    bool follows(const Entry& entry, const Simulation& sim, const Ball& ball) const;
+    bool unchanged(const Entry& entry, const Simulation& sim, double dt) const;
+    // Records a bounce off the brick at (x, y) at time t; false when hits
+    // earlier along the path have already broken it
+    static bool contact(Entry& entry, const BrickGrid& bricks, int x, int y, double t);
+    // Fills in the path; returns whether it reaches the paddle line
+    bool trace(Entry& entry, const Simulation& sim, const Ball& ball) const;
+    struct Tracer;
+    template <class Shape>
+    bool trace(Entry& entry, const Simulation& sim, const Shape& shape, const Ball& ball) const;
+};
+
+#endif
\ No newline at end of file
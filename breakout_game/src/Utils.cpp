@@ -1,45 +1,45 @@
 #include "Utils.h"
 #include <iostream>
-#include <termios.h>
-#include <unistd.h>
-#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 void Utils::clearScreen() {
     std::cout << "\033[2J\033[1;1H";
 }
 
-void Utils::waitForKey() {
-    std::cout << "Press Enter to continue...";
-    std::cin.ignore();
-    std::cin.get();
+void Utils::createDirectory(const std::string& path) {
+    mkdir(path.c_str(), 0755);
 }
 
-bool Utils::kbhit() {
-    struct termios oldt, newt;
-    int ch;
-    int oldf;
-    
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
-    
-    ch = getchar();
-    
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, oldf);
+bool Utils::writeFileAtomic(const std::string& path, const std::string& contents) {
+    std::string temp = path + ".tmp";
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
     
-    if (ch != EOF) {
-        ungetc(ch, stdin);
-        return true;
+    const char* p = contents.data();
+    size_t left = contents.size();
+    bool ok = true;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            ok = false;
+            break;
+        }
+        p += n;
+        left -= n;
     }
+    ok = ok && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
     
-    return false;
-}
-
-void Utils::createDirectory(const std::string& path) {
-    mkdir(path.c_str(), 0755);
+    if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
 }
\ No newline at end of file
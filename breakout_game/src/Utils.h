@@ -6,9 +6,10 @@
 class Utils {
 public:
     static void clearScreen();
-    static void waitForKey();
-    static bool kbhit();
     static void createDirectory(const std::string& path);
+    // Writes contents to path + ".tmp", syncs it and renames it over path,
+    // so path only ever holds a complete file
+    static bool writeFileAtomic(const std::string& path, const std::string& contents);
 };
 
 #endif
\ No newline at end of file
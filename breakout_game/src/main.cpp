@@ -1,10 +1,156 @@
 #include "Game.h"
+#include "EndGame.h"
+#include "Replay.h"
+#include "Evaluator.h"
+#include "Solver.h"
+#include "Spectator.h"
 #include <iostream>
+#include <string>
+#include <cstdlib>
 
-int main() {
+namespace {
+
+bool hasSuffix(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// breakout --convert <in> <out>: converts between .end text and .endb binary
+int convertEndGame(const std::string& in, const std::string& out) {
+    EndGame endgame;
+    bool loaded = hasSuffix(in, ".endb") ? endgame.loadBinary(in) : endgame.loadText(in);
+    if (!loaded) {
+        std::cerr << "Failed to load end game: " << in << std::endl;
+        return 1;
+    }
+    
+    bool saved = hasSuffix(out, ".endb") ? endgame.saveBinary(out) : endgame.saveText(out);
+    if (!saved) {
+        std::cerr << "Failed to save end game: " << out << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// breakout --evaluate [--endgame name | --level n] [--games n] [--threads n]
+//                    [--seed n] [--max-ticks n] [--config name] [--out file.json]
+int evaluate(int argc, char* argv[]) {
+    EvalOptions opts;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--endgame") opts.endgame = value;
+        else if (arg == "--level") opts.level = std::atoi(value.c_str());
+        else if (arg == "--games") opts.games = std::atoi(value.c_str());
+        else if (arg == "--threads") opts.threads = std::atoi(value.c_str());
+        else if (arg == "--seed") opts.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--max-ticks") opts.maxTicks = std::atol(value.c_str());
+        else if (arg == "--config") opts.config = value;
+        else if (arg == "--out") opts.output = value;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+    return runEvaluation(opts);
+}
+
+// breakout --solve <endgame> [--minimize ticks|launches] [--threads n]
+//                 [--max-ticks n] [--max-positions n] [--config name]
+int solve(int argc, char* argv[]) {
+    SolveOptions opts;
+    opts.endgame = argv[2];
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--minimize" && (value == "ticks" || value == "launches")) opts.fewestLaunches = (value == "launches");
+        else if (arg == "--threads") opts.threads = std::atoi(value.c_str());
+        else if (arg == "--max-ticks") opts.maxTicks = std::atol(value.c_str());
+        else if (arg == "--max-positions") opts.maxPositions = std::atol(value.c_str());
+        else if (arg == "--config") opts.config = value;
+        else {
+            std::cerr << "Unknown option: " << arg << " " << value << std::endl;
+            return 1;
+        }
+    }
+    return runSolver(opts);
+}
+
+// breakout [--profile [file.json]] [--autopilot]: the interactive game
+int play(int argc, char* argv[]) {
+    std::string profile;
+    bool autopilot = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--profile") {
+            profile = "profile.json";
+            if (i + 1 < argc && argv[i + 1][0] != '-') profile = argv[++i];
+        } else if (arg == "--autopilot") {
+            autopilot = true;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [--profile [file.json]] [--autopilot]" << std::endl;
+            return 1;
+        }
+    }
+    
+    Game game;
+    if (!profile.empty()) {
+        game.enableProfiler(profile);
+    }
+    if (autopilot) {
+        game.enableAutopilot();
+    }
+    game.run();
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
     try {
-        Game game;
-        game.run();
+        std::string mode = (argc > 1) ? argv[1] : "";
+        if (mode == "--convert") {
+            if (argc != 4) {
+                std::cerr << "Usage: " << argv[0] << " --convert <in.end|in.endb> <out.end|out.endb>" << std::endl;
+                return 1;
+            }
+            return convertEndGame(argv[2], argv[3]);
+        }
+        if (mode == "--replay") {
+            if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--speed")) {
+                std::cerr << "Usage: " << argv[0] << " --replay <file.rep> [--speed 1-100]" << std::endl;
+                return 1;
+            }
+            return runReplay(argv[2], (argc == 5) ? std::atoi(argv[4]) : 0);
+        }
+        if (mode == "--evaluate") {
+            return evaluate(argc, argv);
+        }
+        if (mode == "--solve") {
+            if (argc < 3) {
+                std::cerr << "Usage: " << argv[0] << " --solve <endgame> [--minimize ticks|launches] [--threads n]"
+                          << " [--max-ticks n] [--max-positions n] [--config name]" << std::endl;
+                return 1;
+            }
+            return solve(argc, argv);
+        }
+        if (mode == "--spectate") {
+            if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "--fps")) {
+                std::cerr << "Usage: " << argv[0] << " --spectate [--fps 1-240]" << std::endl;
+                return 1;
+            }
+            return runSpectator((argc == 4) ? std::atoi(argv[3]) : 30);
+        }
+        return play(argc, argv);
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;